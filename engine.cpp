@@ -11,15 +11,45 @@
 #include "search/thread.hpp"
 #include "position/fen.hpp"
 #include "eval/nnue.hpp"
+#include "options.hpp"
 
 void new_game()
 {
     TT::current_generation = 0;
+    TT::loaded_fresh_entries = 0;
+    TT::keep_loaded_generation = false;
     ThreadPool::start_workers(WorkerTask::NewGame);
     ThreadPool::get(0).new_game();
     ThreadPool::wait_for_workers();
 }
 
+void clear_hash()
+{
+    TT::loaded_fresh_entries = 0;
+    TT::keep_loaded_generation = false;
+    ThreadPool::start_workers(WorkerTask::ClearTT);
+    ThreadPool::get(0).clear_tt();
+    ThreadPool::wait_for_workers();
+}
+
+void resize_hash(const uint32_t size_in_mb)
+{
+    if (TT::resize(size_in_mb)) clear_hash();
+    else ThreadPool::clear_tt_stats();
+}
+
+bool set_eval_file(const std::string& path)
+{
+    if (!load_network_file(path, Options::net_cache_dir)) return false;
+
+    for (auto& thread : ThreadPool::threads) thread.eval_cache.clear();
+
+    ThreadPool::start_workers(WorkerTask::Refresh);
+    refresh_accumulators(ThreadPool::get(0).position, ThreadPool::get(0).accumulator_stack);
+    ThreadPool::wait_for_workers();
+    return true;
+}
+
 void start()
 {
     reduction_cal();
@@ -27,10 +57,11 @@ void start()
     Zobrist::generate_keys();
     generate_lines();
     Cuckoo::init();
-    TT::alloc();
 
     std::println("Cataphract v1.5.1 by masceron");
     std::fflush(stdout);
+
+    if (TT::alloc()) clear_hash();
 }
 
 void process_move(Position& position, const std::string_view move, MoveList& list)
@@ -1,9 +1,16 @@
 #pragma once
 
+#include <cstdint>
+#include <string>
+#include <string_view>
+
 struct MoveList;
 struct Position;
 
 void new_game();
+void clear_hash();
+void resize_hash(uint32_t size_in_mb);
+bool set_eval_file(const std::string& path);
 void start();
 void process_move(Position& position, std::string_view move, MoveList& list);
 void set_board(std::string_view fen);
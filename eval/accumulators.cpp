@@ -3,78 +3,25 @@
 
 #include "utils.hpp"
 #include "accumulators.hpp"
+#include "nnue.hpp"
 #include "../position/move.hpp"
 #include "../position/position.hpp"
 
-void AccumulatorEntry::mark_changes(const Position& pos, const Move move)
+AccumulatorStack::AccumulatorStack() : stack{}, size(0)
 {
-    is_dirty = true;
-    require_rebuild = false;
-
-    adds[0] = {0, -1};
-    adds[1] = {0, -1};
-    subs[0] = {0, -1};
-    subs[1] = {0, -1};
-
-    const uint8_t from = move.from();
-    const uint8_t to = move.to();
-    const auto flag = move.flag();
-    const Piece moved_piece = pos.piece_on[to];
-    std::memcpy(bitboards.data(), &pos.boards, sizeof(bitboards));
-    const bool just_moved = !pos.side_to_move;
-
-    if (type_of(moved_piece) == King)
-    {
-        if (const int flip = !just_moved * 56;
-            input_buckets_map[from ^ flip] != input_buckets_map[to ^ flip] || ((from % 8 > 3) != (to % 8 > 3)))
-        {
-            require_rebuild = true;
-        }
-    }
-
-    if (flag < MoveFlag::knight_promotion)
-    {
-        adds[0] = {moved_piece, to};
-        subs[0] = {moved_piece, from};
-        if (flag == MoveFlag::capture)
-        {
-            subs[1] = {pos.state->captured_piece, to};
-        }
-        else if (flag == MoveFlag::ep_capture)
-        {
-            subs[1] = {pos.state->captured_piece, to - Delta<Direction::Up>(just_moved)};
-        }
-        else if (flag == MoveFlag::king_castle)
-        {
-            auto rook = just_moved == white ? R : r;
-            adds[1] = {rook, to - 1};
-            subs[1] = {rook, to + 1};
-        }
-        else if (flag == MoveFlag::queen_castle)
-        {
-            auto rook = just_moved == white ? R : r;
-            adds[1] = {rook, to + 1};
-            subs[1] = {rook, to - 2};
-        }
-    }
-    else
-    {
-        subs[0] = {!just_moved ? P : p, from};
-        adds[0] = {move.promoted_to(just_moved), to};
-        if (flag >= MoveFlag::knight_promo_capture)
-        {
-            subs[1] = {pos.state->captured_piece, to};
-        }
-    }
 }
 
-AccumulatorStack::AccumulatorStack() : stack{}, size(0)
+AccumulatorEntry& AccumulatorStack::next()
 {
+    return stack[size];
 }
 
-void AccumulatorStack::push(const Position& pos, const Move move)
+void AccumulatorStack::push(const Position& pos)
 {
-    stack[size].mark_changes(pos, move);
+    if (pos.state->captured_piece != nil)
+    {
+        prefetch_output_weights(pos);
+    }
     ++size;
 }
 
@@ -101,12 +48,13 @@ AccumulatorEntry& AccumulatorStack::operator[](const int idx)
 void accumulators_set(const Network& __restrict network, const std::array<uint64_t, 14>& boards,
                       int16_t* __restrict accumulators)
 {
-    std::memcpy(accumulators, network.accumulator_biases, HL_SIZE * sizeof(int16_t));
-    std::memcpy(&accumulators[HL_SIZE], network.accumulator_biases, HL_SIZE * sizeof(int16_t));
-
     const std::pair mirror = {lsb(boards[K]) % 8 > 3, lsb(boards[k]) % 8 > 3};
     const auto [white_bucket, black_bucket] = get_buckets(boards);
 
+    const int16_t* white_rows[32];
+    const int16_t* black_rows[32];
+    int count = 0;
+
     for (int i = 0; i < 14; i++)
     {
         if (i == 6 || i == 7) continue;
@@ -116,15 +64,14 @@ void accumulators_set(const Network& __restrict network, const std::array<uint64
         while (board)
         {
             auto [white_add, black_add] = input_index_of(i, pop_lsb(board), mirror);
-            for (int iter = 0; iter < HL_SIZE; iter++)
-            {
-                accumulators[iter] = static_cast<int16_t>(accumulators[iter]
-                    + network.accumulator_weights[white_bucket][white_add][iter]);
-                accumulators[iter + HL_SIZE] = static_cast<int16_t>(accumulators[iter + HL_SIZE] + network.
-                    accumulator_weights[black_bucket][black_add][iter]);
-            }
+            white_rows[count] = network.accumulator_weights[white_bucket][white_add];
+            black_rows[count] = network.accumulator_weights[black_bucket][black_add];
+            count++;
         }
     }
+
+    NNUE::apply_features(network.accumulator_biases, accumulators, white_rows, count, nullptr, 0);
+    NNUE::apply_features(network.accumulator_biases, &accumulators[HL_SIZE], black_rows, count, nullptr, 0);
 }
 
 template <const int exclude>
@@ -137,21 +84,16 @@ void accumulators_addsub(const Network& __restrict network, const int16_t* __res
     auto [white_add, black_add] = input_index_of(add[0].first, add[0].second, mirrors);
     auto [white_sub, black_sub] = input_index_of(sub[0].first, sub[0].second, mirrors);
 
-    for (int iter = 0; iter < HL_SIZE; iter++)
+    if constexpr (exclude != white)
     {
-        if constexpr (exclude != white)
-        {
-            accs[iter] = prev[iter]
-                + network.accumulator_weights[buckets.first][white_add][iter]
-                - network.accumulator_weights[buckets.first][white_sub][iter];
-        }
+        const auto& weights = network.accumulator_weights[buckets.first];
+        NNUE::addsub(prev, accs, weights[white_add], weights[white_sub]);
+    }
 
-        if constexpr (exclude != black)
-        {
-            accs[iter + HL_SIZE] = prev[iter + HL_SIZE]
-                + network.accumulator_weights[buckets.second][black_add][iter]
-                - network.accumulator_weights[buckets.second][black_sub][iter];
-        }
+    if constexpr (exclude != black)
+    {
+        const auto& weights = network.accumulator_weights[buckets.second];
+        NNUE::addsub(&prev[HL_SIZE], &accs[HL_SIZE], weights[black_add], weights[black_sub]);
     }
 }
 
@@ -166,23 +108,16 @@ void accumulators_addsub2(const Network& __restrict network, const int16_t* __re
     auto [white_sub1, black_sub1] = input_index_of(sub[0].first, sub[0].second, mirrors);
     auto [white_sub2, black_sub2] = input_index_of(sub[1].first, sub[1].second, mirrors);
 
-    for (int iter = 0; iter < HL_SIZE; iter++)
+    if constexpr (exclude != white)
     {
-        if constexpr (exclude != white)
-        {
-            accs[iter] = prev[iter]
-                + network.accumulator_weights[buckets.first][white_add][iter]
-                - network.accumulator_weights[buckets.first][white_sub1][iter]
-                - network.accumulator_weights[buckets.first][white_sub2][iter];
-        }
+        const auto& weights = network.accumulator_weights[buckets.first];
+        NNUE::addsub2(prev, accs, weights[white_add], weights[white_sub1], weights[white_sub2]);
+    }
 
-        if constexpr (exclude != black)
-        {
-            accs[iter + HL_SIZE] = prev[iter + HL_SIZE]
-                + network.accumulator_weights[buckets.second][black_add][iter]
-                - network.accumulator_weights[buckets.second][black_sub1][iter]
-                - network.accumulator_weights[buckets.second][black_sub2][iter];
-        }
+    if constexpr (exclude != black)
+    {
+        const auto& weights = network.accumulator_weights[buckets.second];
+        NNUE::addsub2(&prev[HL_SIZE], &accs[HL_SIZE], weights[black_add], weights[black_sub1], weights[black_sub2]);
     }
 }
 
@@ -200,25 +135,18 @@ void accumulators_add2sub2(const Network& __restrict network, const int16_t* __r
     auto [white_sub1, black_sub1] = input_index_of(sub[0].first, sub[0].second, mirrors);
     auto [white_sub2, black_sub2] = input_index_of(sub[1].first, sub[1].second, mirrors);
 
-    for (int iter = 0; iter < HL_SIZE; iter++)
+    if constexpr (exclude != white)
     {
-        if constexpr (exclude != white)
-        {
-            accs[iter] = prev[iter]
-                + network.accumulator_weights[buckets.first][white_add1][iter]
-                + network.accumulator_weights[buckets.first][white_add2][iter]
-                - network.accumulator_weights[buckets.first][white_sub1][iter]
-                - network.accumulator_weights[buckets.first][white_sub2][iter];
-        }
+        const auto& weights = network.accumulator_weights[buckets.first];
+        NNUE::add2sub2(prev, accs, weights[white_add1], weights[white_add2], weights[white_sub1],
+                       weights[white_sub2]);
+    }
 
-        if constexpr (exclude != black)
-        {
-            accs[iter + HL_SIZE] = prev[iter + HL_SIZE]
-                + network.accumulator_weights[buckets.second][black_add1][iter]
-                + network.accumulator_weights[buckets.second][black_add2][iter]
-                - network.accumulator_weights[buckets.second][black_sub1][iter]
-                - network.accumulator_weights[buckets.second][black_sub2][iter];
-        }
+    if constexpr (exclude != black)
+    {
+        const auto& weights = network.accumulator_weights[buckets.second];
+        NNUE::add2sub2(&prev[HL_SIZE], &accs[HL_SIZE], weights[black_add1], weights[black_add2],
+                       weights[black_sub1], weights[black_sub2]);
     }
 }
 
@@ -254,19 +182,116 @@ void update_from_move(const Network& __restrict network, int16_t* __restrict pre
     }
 }
 
+static constexpr int max_fused_plies = 16;
+
+static void add_feature(std::pair<uint8_t, int8_t>* features, int& count,
+                        std::pair<uint8_t, int8_t>* opposites, int& opposite_count,
+                        const std::pair<uint8_t, int8_t>& feature)
+{
+    if (feature.second == -1) return;
+
+    for (int i = 0; i < opposite_count; i++)
+    {
+        if (opposites[i] == feature)
+        {
+            opposites[i] = opposites[--opposite_count];
+            return;
+        }
+    }
+
+    features[count++] = feature;
+}
+
+void accumulators_fused_update(const Network& __restrict network, AccumulatorStack& accumulator_stack,
+                               const int first, const int last, const std::pair<bool, bool>& mirrors,
+                               const std::pair<uint8_t, uint8_t>& buckets)
+{
+    std::pair<uint8_t, int8_t> adds[2 * max_fused_plies];
+    std::pair<uint8_t, int8_t> subs[2 * max_fused_plies];
+    int add_count = 0;
+    int sub_count = 0;
+
+    for (int idx = first; idx <= last; idx++)
+    {
+        const auto& entry = accumulator_stack[idx];
+        for (const auto& add : entry.adds) add_feature(adds, add_count, subs, sub_count, add);
+        for (const auto& sub : entry.subs) add_feature(subs, sub_count, adds, add_count, sub);
+    }
+
+    const int16_t* white_adds[2 * max_fused_plies];
+    const int16_t* black_adds[2 * max_fused_plies];
+    const int16_t* white_subs[2 * max_fused_plies];
+    const int16_t* black_subs[2 * max_fused_plies];
+
+    const auto& white_weights = network.accumulator_weights[buckets.first];
+    const auto& black_weights = network.accumulator_weights[buckets.second];
+
+    for (int i = 0; i < add_count; i++)
+    {
+        const auto [white_index, black_index] = input_index_of(adds[i].first, adds[i].second, mirrors);
+        white_adds[i] = white_weights[white_index];
+        black_adds[i] = black_weights[black_index];
+    }
+
+    for (int i = 0; i < sub_count; i++)
+    {
+        const auto [white_index, black_index] = input_index_of(subs[i].first, subs[i].second, mirrors);
+        white_subs[i] = white_weights[white_index];
+        black_subs[i] = black_weights[black_index];
+    }
+
+    const auto previous = accumulator_stack[first - 1].accumulators;
+    const auto current = accumulator_stack[last].accumulators;
+
+    NNUE::apply_features(previous, current, white_adds, add_count, white_subs, sub_count);
+    NNUE::apply_features(&previous[HL_SIZE], &current[HL_SIZE], black_adds, add_count, black_subs, sub_count);
+}
+
+static void finny_refresh(const Network& __restrict network, FinnyEntry& entry,
+                          const std::array<uint64_t, 14>& boards, const bool perspective, const bool mirror,
+                          const uint8_t bucket)
+{
+    const auto& weights = network.accumulator_weights[bucket];
+
+    const int16_t* adds[32];
+    const int16_t* subs[32];
+    int add_count = 0;
+    int sub_count = 0;
+
+    auto orient = [&](uint64_t board)
+    {
+        if (mirror) board = horizontal_mirror(board);
+        return perspective == white ? std::byteswap(board) : board;
+    };
+
+    for (int piece = 0; piece < 14; piece++)
+    {
+        if (piece == 6 || piece == 7) continue;
+
+        const int offset = nnue_index(perspective == white ? piece : flip_color(piece)) * 64;
+
+        auto piece_adds = orient(boards[piece] & ~entry.bitboards[piece]);
+        while (piece_adds) adds[add_count++] = weights[pop_lsb(piece_adds) + offset];
+
+        auto piece_subs = orient(entry.bitboards[piece] & ~boards[piece]);
+        while (piece_subs) subs[sub_count++] = weights[pop_lsb(piece_subs) + offset];
+    }
+
+    NNUE::apply_features(entry.accumulators, entry.accumulators, adds, add_count, subs, sub_count);
+    entry.bitboards = boards;
+}
+
 void accumulator_stack_update(const Network& __restrict network, AccumulatorStack& accumulator_stack)
 {
     auto idx = accumulator_stack.size - 1;
     while (accumulator_stack[idx - 1].is_dirty) idx--;
-    auto& finny_table = accumulator_stack.finny_table;
 
     for (; idx < accumulator_stack.size; idx++)
     {
         auto& stack_entry = accumulator_stack[idx];
-        auto& new_bitboards = stack_entry.bitboards;
-        const auto new_buckets = get_buckets(new_bitboards);
+        const auto new_buckets = get_buckets(stack_entry.kings);
         const std::pair new_mirrors = {
-            lsb(new_bitboards[K]) % 8 > 3, lsb(new_bitboards[k]) % 8 > 3
+            stack_entry.kings.first % 8 > 3, stack_entry.kings.second % 8 > 3
         };
         const auto current_accumulators = stack_entry.accumulators;
 
@@ -274,125 +299,48 @@ void accumulator_stack_update(const Network& __restrict network, AccumulatorStac
 
         if (!stack_entry.require_rebuild)
         {
-            update_from_move<-1>(network, previous_accumulators, current_accumulators, stack_entry.adds,
-                                 stack_entry.subs, new_mirrors, new_buckets);
-        }
-        else
-        {
-            auto& previous_entry = accumulator_stack[idx - 1];
-            const auto& previous_boards = previous_entry.bitboards;
-            const auto previous_buckets = get_buckets(previous_boards);
-            const auto [white_bucket, black_bucket] = new_buckets;
-            auto& [saved_bitboards, saved_accumulators] = finny_table[white_bucket][black_bucket];
-
-            bool to_update;
-
-            const std::pair saved_mirrors = {
-                saved_bitboards[K] && lsb(saved_bitboards[K]) % 8 > 3,
-                saved_bitboards[k] && lsb(saved_bitboards[k]) % 8 > 3
-            };
+            auto last = idx;
+            while (last + 1 < accumulator_stack.size && !accumulator_stack[last + 1].require_rebuild
+                && last + 1 - idx < max_fused_plies)
+            {
+                last++;
+            }
 
-            if (previous_buckets != new_buckets)
+            if (last == idx)
             {
-                to_update = white_bucket == previous_buckets.first;
+                update_from_move<-1>(network, previous_accumulators, current_accumulators, stack_entry.adds,
+                                     stack_entry.subs, new_mirrors, new_buckets);
             }
             else
             {
-                to_update = new_mirrors.first == (lsb(previous_boards[K]) % 8 > 3);
+                accumulators_fused_update(network, accumulator_stack, idx, last, new_mirrors, new_buckets);
+                idx = last;
             }
+        }
+        else
+        {
+            // only the side whose king moved needs its perspective rebuilt, the other one is updated from the move
+            const bool perspective = stack_entry.kings.first != accumulator_stack[idx - 1].kings.first ? white : black;
+            const uint8_t bucket = perspective == white ? new_buckets.first : new_buckets.second;
+            const bool mirror = perspective == white ? new_mirrors.first : new_mirrors.second;
+            auto& finny_entry = accumulator_stack.finny_table[perspective][bucket][mirror];
 
-            if (!to_update)
-            {
-                for (int piece = 0; piece < 14; piece++)
-                {
-                    if (piece == 6 || piece == 7) continue;
-
-                    const auto old_white = saved_mirrors.first
-                                               ? horizontal_mirror(saved_bitboards[piece])
-                                               : saved_bitboards[piece];
-                    const auto new_white = new_mirrors.first
-                                               ? horizontal_mirror(new_bitboards[piece])
-                                               : new_bitboards[piece];
-                    auto white_adds = std::byteswap(new_white & ~old_white);
-
-                    while (white_adds)
-                    {
-                        const int index_added = pop_lsb(white_adds);
-                        const int input_index = index_added + nnue_index(piece) * 64;
-                        for (int iter = 0; iter < HL_SIZE; iter++)
-                        {
-                            saved_accumulators[iter] = static_cast<int16_t>(saved_accumulators[iter] + network.
-                                accumulator_weights[white_bucket][input_index][iter]);
-                        }
-                    }
-
-                    auto white_subs = std::byteswap(old_white & ~new_white);
-
-                    while (white_subs)
-                    {
-                        const int index_subbed = pop_lsb(white_subs);
-                        const int input_index = index_subbed + nnue_index(piece) * 64;
-                        for (int iter = 0; iter < HL_SIZE; iter++)
-                        {
-                            saved_accumulators[iter] = static_cast<int16_t>(saved_accumulators[iter] - network.
-                                accumulator_weights[white_bucket][input_index][iter]);
-                        }
-                    }
-                }
+            finny_refresh(network, finny_entry, stack_entry.bitboards, perspective, mirror, bucket);
 
+            if (perspective == white)
+            {
                 update_from_move<white>(network, previous_accumulators, current_accumulators, stack_entry.adds,
                                         stack_entry.subs, new_mirrors, new_buckets);
-                std::memcpy(current_accumulators, saved_accumulators, HL_SIZE * sizeof(int16_t));
-                std::memcpy(&saved_accumulators[HL_SIZE], &current_accumulators[HL_SIZE], HL_SIZE * sizeof(int16_t));
+                std::memcpy(current_accumulators, finny_entry.accumulators, HL_SIZE * sizeof(int16_t));
             }
             else
             {
-                for (int piece = 0; piece < 14; piece++)
-                {
-                    if (piece == 6 || piece == 7) continue;
-
-                    const auto old_black = saved_mirrors.second
-                                               ? horizontal_mirror(saved_bitboards[piece])
-                                               : saved_bitboards[piece];
-
-                    const auto new_black = new_mirrors.second
-                                               ? horizontal_mirror(new_bitboards[piece])
-                                               : new_bitboards[piece];
-                    auto black_adds = new_black & ~old_black;
-
-                    while (black_adds)
-                    {
-                        const int index_added = pop_lsb(black_adds);
-                        const int input_index = index_added + nnue_index(flip_color(piece)) * 64;
-                        for (int iter = 0; iter < HL_SIZE; iter++)
-                        {
-                            saved_accumulators[iter + HL_SIZE] = static_cast<int16_t>(saved_accumulators[iter + HL_SIZE]
-                                + network.accumulator_weights[black_bucket][input_index][iter]);
-                        }
-                    }
-
-                    auto black_subs = old_black & ~new_black;
-
-                    while (black_subs)
-                    {
-                        const int index_subbed = pop_lsb(black_subs);
-                        const int input_index = index_subbed + nnue_index(flip_color(piece)) * 64;
-                        for (int iter = 0; iter < HL_SIZE; iter++)
-                        {
-                            saved_accumulators[iter + HL_SIZE] = static_cast<int16_t>(saved_accumulators[iter + HL_SIZE]
-                                - network.accumulator_weights[black_bucket][input_index][iter]);
-                        }
-                    }
-                }
                 update_from_move<black>(network, previous_accumulators, current_accumulators, stack_entry.adds,
                                         stack_entry.subs, new_mirrors, new_buckets);
-                std::memcpy(&current_accumulators[HL_SIZE], &saved_accumulators[HL_SIZE], HL_SIZE * sizeof(int16_t));
-                std::memcpy(saved_accumulators, current_accumulators, HL_SIZE * sizeof(int16_t));
+                std::memcpy(&current_accumulators[HL_SIZE], finny_entry.accumulators, HL_SIZE * sizeof(int16_t));
             }
-
-            std::memcpy(saved_bitboards.data(), new_bitboards.data(), sizeof(new_bitboards));
         }
 
-        stack_entry.is_dirty = false;
+        accumulator_stack[idx].is_dirty = false;
     }
 }
@@ -5,35 +5,34 @@
 #include "arch.hpp"
 #include "simd/simd.hpp"
 
-struct Move;
 struct Position;
 
 struct AccumulatorEntry
 {
     SIMD_ALIGN int16_t accumulators[2 * HL_SIZE];
     std::array<uint64_t, 14> bitboards;
+    std::pair<uint8_t, uint8_t> kings;
     std::pair<uint8_t, int8_t> adds[2];
     std::pair<uint8_t, int8_t> subs[2];
     bool is_dirty;
     bool require_rebuild;
-
-    void mark_changes(const Position& pos, Move move);
 };
 
 struct FinnyEntry
 {
     std::array<uint64_t, 14> bitboards;
-    SIMD_ALIGN int16_t accumulators[2 * HL_SIZE];
+    SIMD_ALIGN int16_t accumulators[HL_SIZE];
 };
 
 struct AccumulatorStack
 {
     AccumulatorEntry stack[130];
     int size;
-    FinnyEntry finny_table[INPUT_BUCKETS][INPUT_BUCKETS];
+    FinnyEntry finny_table[2][INPUT_BUCKETS][2];
 
     AccumulatorStack();
-    void push(const Position& pos, Move move);
+    AccumulatorEntry& next();
+    void push(const Position& pos);
     void push();
     void clear();
     void pop();
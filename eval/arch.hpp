@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <cstddef>
 
 #define HL_SIZE 1280
 #define INPUT_SIZE 768
@@ -19,6 +20,32 @@ struct Network
     int16_t output_bias[OUTPUT_BUCKETS];
 };
 
+enum class NetFormat: uint32_t
+{
+    int16, int8
+};
+
+struct NetHeader
+{
+    char magic[8];
+    uint32_t version;
+    NetFormat format;
+    uint32_t input_buckets;
+    uint32_t input_size;
+    uint32_t hl_size;
+    uint32_t output_buckets;
+    uint32_t ft_shift;
+    uint8_t padding[28];
+};
+
+inline constexpr char net_magic[8] = "CATANET";
+inline constexpr uint32_t net_version = 1;
+inline constexpr size_t padded_net_size = (sizeof(Network) + 63) / 64 * 64;
+inline constexpr size_t int8_net_size = sizeof(NetHeader) + sizeof(Network)
+    - sizeof(Network::accumulator_weights) / 2;
+
+static_assert(sizeof(NetHeader) == 64);
+
 inline constexpr uint8_t input_buckets_map[] = {
     0,  1,  2,  3,  3,  2,  1, 0,
     4,  5,  6,  7,  7,  6,  5, 4,
@@ -0,0 +1,26 @@
+#include "eval_cache.hpp"
+
+static constexpr uint64_t key_mask = ~0xFFFFull;
+
+bool EvalCache::probe(const uint64_t key, int16_t& evaluation)
+{
+    ++probes;
+    const uint64_t entry = entries[key & (entry_count - 1)];
+    if ((entry & key_mask) != (key & key_mask)) return false;
+
+    ++hits;
+    evaluation = static_cast<int16_t>(entry & 0xFFFF);
+    return true;
+}
+
+void EvalCache::store(const uint64_t key, const int16_t evaluation)
+{
+    entries[key & (entry_count - 1)] = (key & key_mask) | static_cast<uint16_t>(evaluation);
+}
+
+void EvalCache::clear()
+{
+    entries.fill(0);
+    probes = 0;
+    hits = 0;
+}
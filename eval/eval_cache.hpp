@@ -0,0 +1,19 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+struct EvalCache
+{
+    static constexpr size_t entry_count = 8192;
+
+    // upper 48 bits of the position key, raw network output in the low 16
+    std::array<uint64_t, entry_count> entries;
+    uint64_t probes;
+    uint64_t hits;
+
+    bool probe(uint64_t key, int16_t& evaluation);
+    void store(uint64_t key, int16_t evaluation);
+    void clear();
+};
@@ -1,34 +1,280 @@
 #include <cstring>
+#include <cstdlib>
+#include <cstdio>
 #include <algorithm>
+#include <chrono>
+#include <print>
+#include <charconv>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <filesystem>
+#endif
 
 #include "nnue.hpp"
 #include "accumulators.hpp"
 #include "simd/simd.hpp"
 #include "arch.hpp"
 #include "utils.hpp"
+#include "../board/bitboard.hpp"
 #include "../position/position.hpp"
+#include "../position/fen.hpp"
+#include "../position/bench.hpp"
 
+// the shipped net stays int16 since it loses precision as int8; int8 nets are widened to int16 at load either way
 SIMD_ALIGN inline static constexpr unsigned char data[] = {
 #embed "../net.bin"
 };
 
-static const Network& network = *reinterpret_cast<const Network*>(data);
+static const Network* network = nullptr;
+static Network* owned_network = nullptr;
+static void* network_mapping = nullptr;
+static size_t network_mapping_size = 0;
+
+static Network* allocate_network()
+{
+    return static_cast<Network*>(std::aligned_alloc(64, padded_net_size));
+}
+
+static bool valid_header(const NetHeader& header, const size_t size)
+{
+    if (std::memcmp(header.magic, net_magic, sizeof(net_magic)) != 0
+        || header.version != net_version
+        || header.input_buckets != INPUT_BUCKETS
+        || header.input_size != INPUT_SIZE
+        || header.hl_size != HL_SIZE
+        || header.output_buckets != OUTPUT_BUCKETS)
+        return false;
+
+    if (header.format == NetFormat::int16) return size == sizeof(NetHeader) + sizeof(Network);
+    if (header.format == NetFormat::int8) return size == int8_net_size && header.ft_shift <= 8;
+    return false;
+}
+
+static const Network* decode_network(const unsigned char* bytes, const size_t size, Network*& storage)
+{
+    storage = nullptr;
+
+    if (size == sizeof(Network) || size == padded_net_size)
+    {
+        if (reinterpret_cast<uintptr_t>(bytes) % 64 == 0) return reinterpret_cast<const Network*>(bytes);
+
+        storage = allocate_network();
+        if (storage) std::memcpy(storage, bytes, sizeof(Network));
+        return storage;
+    }
+
+    NetHeader header{};
+    if (size < sizeof(header)) return nullptr;
+    std::memcpy(&header, bytes, sizeof(header));
+    if (!valid_header(header, size)) return nullptr;
+
+    const auto payload = bytes + sizeof(NetHeader);
+
+    if (header.format == NetFormat::int16)
+    {
+        return decode_network(payload, sizeof(Network), storage);
+    }
+
+    storage = allocate_network();
+    if (!storage) return nullptr;
+
+    static constexpr size_t weight_count = sizeof(Network::accumulator_weights) / sizeof(int16_t);
+    const auto weights = reinterpret_cast<const int8_t*>(payload);
+    const auto widened = &storage->accumulator_weights[0][0][0];
+    for (size_t i = 0; i < weight_count; i++)
+    {
+        widened[i] = static_cast<int16_t>(weights[i] * (1 << header.ft_shift));
+    }
+
+    std::memcpy(storage->accumulator_biases, payload + weight_count,
+                sizeof(Network) - sizeof(Network::accumulator_weights));
+    return storage;
+}
+
+static void install_network(const Network* decoded, Network* storage, void* mapping, const size_t mapping_size)
+{
+    std::free(owned_network);
+#ifdef __linux__
+    if (network_mapping) munmap(network_mapping, network_mapping_size);
+#endif
+    owned_network = storage;
+    network_mapping = mapping;
+    network_mapping_size = mapping_size;
+    network = decoded;
+}
+
+bool load_network(const unsigned char* bytes, const size_t size)
+{
+    Network* storage;
+    const Network* decoded = decode_network(bytes, size, storage);
+    if (!decoded) return false;
+
+    install_network(decoded, storage, nullptr, 0);
+    return true;
+}
+
+#ifdef __linux__
+static void* map_file(const std::string& path, size_t& size)
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+
+    struct stat file_stat{};
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size <= 0)
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    size = static_cast<size_t>(file_stat.st_size);
+    void* memory = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    return memory == MAP_FAILED ? nullptr : memory;
+}
+
+static uint64_t fingerprint(const unsigned char* bytes, const size_t size)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    return hash;
+}
+
+static bool map_cached_network(const std::string& cache_path)
+{
+    size_t size;
+    void* memory = map_file(cache_path, size);
+    if (!memory) return false;
+
+    Network* storage;
+    const Network* decoded = decode_network(static_cast<const unsigned char*>(memory), size, storage);
+    if (!decoded || storage)
+    {
+        std::free(storage);
+        munmap(memory, size);
+        return false;
+    }
+
+    madvise(memory, size, MADV_WILLNEED);
+    install_network(decoded, nullptr, memory, size);
+    return true;
+}
+
+static bool write_cached_network(const std::string& cache_path, const Network& net)
+{
+    const std::string temp_path = cache_path + "." + std::to_string(getpid()) + ".tmp";
+    std::FILE* file = std::fopen(temp_path.c_str(), "wb");
+    if (!file) return false;
+
+    const bool written = std::fwrite(&net, sizeof(Network), 1, file) == 1;
+    if (std::fclose(file) != 0 || !written)
+    {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+
+    return std::rename(temp_path.c_str(), cache_path.c_str()) == 0;
+}
+#endif
+
+bool load_network_file(const std::string& path, const std::string& cache_dir)
+{
+    if (path.empty()) return load_network(data, sizeof(data));
+
+#ifdef __linux__
+    size_t file_size;
+    void* memory = map_file(path, file_size);
+    if (!memory) return false;
+
+    Network* storage;
+    const Network* decoded = decode_network(static_cast<const unsigned char*>(memory), file_size, storage);
+    if (!decoded)
+    {
+        munmap(memory, file_size);
+        return false;
+    }
+
+    if (!storage)
+    {
+        madvise(memory, file_size, MADV_WILLNEED);
+        install_network(decoded, nullptr, memory, file_size);
+        return true;
+    }
+
+    std::string cache_path;
+    if (!cache_dir.empty())
+    {
+        char name[16];
+        const auto hash = fingerprint(static_cast<const unsigned char*>(memory), file_size);
+        const auto end = std::to_chars(name, name + sizeof(name), hash, 16).ptr;
+        cache_path = cache_dir + "/cataphract-" + std::string(name, end) + ".nnue";
+    }
+    munmap(memory, file_size);
+
+    if (!cache_path.empty()
+        && (map_cached_network(cache_path)
+            || (write_cached_network(cache_path, *storage) && map_cached_network(cache_path))))
+    {
+        std::free(storage);
+        return true;
+    }
+
+    install_network(decoded, storage, nullptr, 0);
+#else
+    std::error_code error;
+    const auto file_size = std::filesystem::file_size(path, error);
+    if (error) return false;
+
+    std::vector<unsigned char> bytes(file_size);
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+    const bool read = std::fread(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    std::fclose(file);
+    if (!read) return false;
+
+    Network* storage;
+    const Network* decoded = decode_network(bytes.data(), bytes.size(), storage);
+    if (!decoded) return false;
+
+    if (!storage)
+    {
+        storage = allocate_network();
+        if (!storage) return false;
+        std::memcpy(storage, decoded, sizeof(Network));
+        decoded = storage;
+    }
+
+    install_network(decoded, storage, nullptr, 0);
+#endif
+    return true;
+}
+
+static const bool embedded_network_loaded = load_network(data, sizeof(data));
 
 void update_accumulators(AccumulatorStack& accumulator_stack)
 {
-    accumulator_stack_update(network, accumulator_stack);
+    accumulator_stack_update(*network, accumulator_stack);
 }
 
 void refresh_accumulators(const Position& pos, AccumulatorStack& accumulator_stack)
 {
-    auto& finny_table = accumulator_stack.finny_table;
-    for (auto& pair : finny_table)
+    for (auto& perspective : accumulator_stack.finny_table)
     {
-        for (auto& [bitboards, accumulators] : pair)
+        for (auto& bucket : perspective)
         {
-            std::ranges::fill(bitboards.begin(), bitboards.end(), 0);
-            std::memcpy(accumulators, network.accumulator_biases, HL_SIZE * sizeof(int16_t));
-            std::memcpy(&accumulators[HL_SIZE], network.accumulator_biases, HL_SIZE * sizeof(int16_t));
+            for (auto& [bitboards, accumulators] : bucket)
+            {
+                std::ranges::fill(bitboards.begin(), bitboards.end(), 0);
+                std::memcpy(accumulators, network->accumulator_biases, HL_SIZE * sizeof(int16_t));
+            }
         }
     }
     accumulator_stack.clear();
@@ -36,24 +282,66 @@ void refresh_accumulators(const Position& pos, AccumulatorStack& accumulator_sta
     const auto [w, b] = get_buckets(pos.boards);
 
     auto& stack_entry = accumulator_stack[0];
-    auto& finny_entry = finny_table[w][b];
-
+    stack_entry.kings = king_squares(pos.boards);
     std::memcpy(stack_entry.bitboards.data(), pos.boards.data(), sizeof(pos.boards));
-    std::memcpy(finny_entry.bitboards.data(), pos.boards.data(), sizeof(pos.boards));
 
     stack_entry.is_dirty = false;
-    accumulators_set(network, pos.boards, stack_entry.accumulators);
-    std::memcpy(finny_entry.accumulators, stack_entry.accumulators, 2 * HL_SIZE * sizeof(int16_t));
+    accumulators_set(*network, pos.boards, stack_entry.accumulators);
+
+    auto& white_entry = accumulator_stack.finny_table[white][w][stack_entry.kings.first % 8 > 3];
+    auto& black_entry = accumulator_stack.finny_table[black][b][stack_entry.kings.second % 8 > 3];
+    white_entry.bitboards = pos.boards;
+    black_entry.bitboards = pos.boards;
+    std::memcpy(white_entry.accumulators, stack_entry.accumulators, HL_SIZE * sizeof(int16_t));
+    std::memcpy(black_entry.accumulators, &stack_entry.accumulators[HL_SIZE], HL_SIZE * sizeof(int16_t));
 }
 
-int16_t evaluate(const Position& pos, int16_t* accumulator_pair)
+static uint8_t output_bucket(const int piece_count)
 {
     static constexpr uint8_t divisor = (32 + OUTPUT_BUCKETS - 1) / OUTPUT_BUCKETS;
-    const uint8_t bucket = (std::popcount(pos.occupations[2]) - 2) / divisor;
-    const int32_t evaluation = NNUE::forward(network, &accumulator_pair[pos.side_to_move * HL_SIZE],
+    return (piece_count - 2) / divisor;
+}
+
+static uint8_t output_bucket(const Position& pos)
+{
+    return output_bucket(std::popcount(pos.occupations[2]));
+}
+
+static void prefetch_output_weights(const uint8_t bucket)
+{
+    const auto weights = reinterpret_cast<const char*>(network->output_weights[bucket]);
+    for (size_t offset = 0; offset < sizeof(network->output_weights[bucket]); offset += 64)
+    {
+        __builtin_prefetch(&weights[offset]);
+    }
+}
+
+void prefetch_output_weights(const Position& pos)
+{
+    const int piece_count = std::popcount(pos.occupations[2]);
+    const uint8_t bucket = output_bucket(piece_count);
+
+    // the parent's bucket is still hot, only a capture crossing into a new bucket needs its weights fetched
+    if (bucket != output_bucket(piece_count + 1)) prefetch_output_weights(bucket);
+}
+
+static int16_t scale_output(const Network& net, const int32_t evaluation, const uint8_t bucket)
+{
+    return static_cast<int16_t>((evaluation / QA + net.output_bias[bucket]) * EVAL_SCALE / (QA * QB));
+}
+
+static int16_t evaluate(const Network& net, const Position& pos, const int16_t* accumulator_pair)
+{
+    const uint8_t bucket = output_bucket(pos);
+    const int32_t evaluation = NNUE::forward(net, &accumulator_pair[pos.side_to_move * HL_SIZE],
                                        &accumulator_pair[!pos.side_to_move * HL_SIZE], bucket);
 
-    return static_cast<int16_t>((evaluation / QA + network.output_bias[bucket]) * EVAL_SCALE / (QA * QB));
+    return scale_output(net, evaluation, bucket);
+}
+
+int16_t evaluate(const Position& pos, int16_t* accumulator_pair)
+{
+    return evaluate(*network, pos, accumulator_pair);
 }
 
 int16_t eval(const Position& pos, AccumulatorStack& accumulator_stack)
@@ -65,4 +353,267 @@ int16_t eval(const Position& pos, AccumulatorStack& accumulator_stack)
     }
 
     return evaluate(pos, back.accumulators);
-}
\ No newline at end of file
+}
+
+void eval_batch(const std::span<const Position> positions, const std::span<int16_t> scores)
+{
+    struct AccumulatorPair
+    {
+        SIMD_ALIGN int16_t values[2 * HL_SIZE];
+    };
+
+    std::vector<AccumulatorPair> accumulators(positions.size());
+    std::vector<uint8_t> buckets(positions.size());
+    std::vector<uint32_t> order(positions.size());
+
+    for (size_t i = 0; i < positions.size(); i++)
+    {
+        accumulators_set(*network, positions[i].boards, accumulators[i].values);
+        buckets[i] = output_bucket(positions[i]);
+        order[i] = static_cast<uint32_t>(i);
+    }
+
+    // positions sharing an output bucket share weights, so group them and score forward_batch_size at a time
+    std::ranges::stable_sort(order, {}, [&](const uint32_t i) { return buckets[i]; });
+
+    for (size_t start = 0; start < order.size();)
+    {
+        const uint8_t bucket = buckets[order[start]];
+        const int16_t* stm[NNUE::forward_batch_size];
+        const int16_t* nstm[NNUE::forward_batch_size];
+
+        int count = 0;
+        while (count < NNUE::forward_batch_size && start + count < order.size() && buckets[order[start + count]] == bucket)
+        {
+            const uint32_t idx = order[start + count];
+            const bool side = positions[idx].side_to_move;
+            stm[count] = &accumulators[idx].values[side * HL_SIZE];
+            nstm[count] = &accumulators[idx].values[!side * HL_SIZE];
+            count++;
+        }
+
+        int32_t results[NNUE::forward_batch_size];
+        NNUE::forward_batch(*network, stm, nstm, count, bucket, results);
+
+        for (int p = 0; p < count; p++) scores[order[start + p]] = scale_output(*network, results[p], bucket);
+        start += count;
+    }
+}
+
+// runs the accumulator kernels of a table on random rows and compares every output with the scalar path
+static bool accumulator_kernels_match_scalar(const NNUE::Kernels& kernels)
+{
+    struct Row
+    {
+        SIMD_ALIGN int16_t values[HL_SIZE];
+    };
+
+    static constexpr int row_count = 36;
+    std::vector<Row> rows(row_count);
+    Row expected{};
+    Row actual{};
+
+    std::mt19937 generator(0xC0FFEE);
+    for (auto& row : rows)
+        for (auto& value : row.values) value = static_cast<int16_t>(static_cast<int>(generator() % 2001) - 1000);
+
+    const auto* scalar = NNUE::scalar_kernels;
+    bool match = true;
+    auto compare = [&] { match &= std::memcmp(expected.values, actual.values, sizeof(expected.values)) == 0; };
+
+    const auto prev = rows[0].values;
+    const auto row = [&](const int idx) { return rows[idx].values; };
+
+    scalar->addsub(prev, expected.values, row(1), row(2));
+    kernels.addsub(prev, actual.values, row(1), row(2));
+    compare();
+
+    scalar->addsub2(prev, expected.values, row(1), row(2), row(3));
+    kernels.addsub2(prev, actual.values, row(1), row(2), row(3));
+    compare();
+
+    scalar->add2sub2(prev, expected.values, row(1), row(2), row(3), row(4));
+    kernels.add2sub2(prev, actual.values, row(1), row(2), row(3), row(4));
+    compare();
+
+    const int16_t* features[row_count - 1];
+    for (int i = 0; i < row_count - 1; i++) features[i] = row(i + 1);
+
+    for (const auto& [add_count, sub_count] : {std::pair{0, 0}, {1, 1}, {3, 2}, {4, 4}, {32, 0}, {17, 3}})
+    {
+        scalar->apply_features(prev, expected.values, features, add_count, &features[add_count], sub_count);
+        kernels.apply_features(prev, actual.values, features, add_count, &features[add_count], sub_count);
+        compare();
+    }
+
+    return match;
+}
+
+void bench_forward(const Position& pos, AccumulatorStack& accumulator_stack, const uint64_t iterations)
+{
+    refresh_accumulators(pos, accumulator_stack);
+
+    const auto accumulators = accumulator_stack[0].accumulators;
+    const auto stm = &accumulators[pos.side_to_move * HL_SIZE];
+    const auto nstm = &accumulators[!pos.side_to_move * HL_SIZE];
+
+    // walked between cold calls to push the output weights out of L1 and L2
+    std::vector<char> eviction_buffer(8 * 1024 * 1024, 1);
+    const uint64_t cold_iterations = std::max<uint64_t>(1, iterations / 1000);
+
+    auto elapsed_ns = [](const auto start_time)
+    {
+        return std::max<int64_t>(1, std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_time).count());
+    };
+
+    for (const auto* kernels : NNUE::supported_kernels())
+    {
+        std::println("info string {} accumulator kernels {}", kernels->name,
+                     accumulator_kernels_match_scalar(*kernels) ? "match scalar" : "DIFFER FROM SCALAR");
+
+        int64_t checksum = 0;
+        auto start_time = std::chrono::steady_clock::now();
+
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            checksum += kernels->forward(*network, stm, nstm, i % OUTPUT_BUCKETS);
+        }
+
+        const int64_t throughput_ns = elapsed_ns(start_time);
+
+        // each bucket depends on the previous result, so calls cannot overlap
+        uint8_t bucket = 0;
+        start_time = std::chrono::steady_clock::now();
+
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            const int32_t result = kernels->forward(*network, stm, nstm, bucket);
+            checksum += result;
+            bucket = (bucket + 1 + (result & 1)) % OUTPUT_BUCKETS;
+        }
+
+        const int64_t latency_ns = elapsed_ns(start_time);
+
+        int64_t cold_ns = 0;
+        int64_t prefetched_ns = 0;
+        for (uint64_t i = 0; i < 2 * cold_iterations; i++)
+        {
+            const bool prefetch = i & 1;
+            const uint8_t cold_bucket = i / 2 % OUTPUT_BUCKETS;
+
+            for (size_t offset = 0; offset < eviction_buffer.size(); offset += 64) checksum += eviction_buffer[offset];
+            if (prefetch) prefetch_output_weights(cold_bucket);
+            for (size_t offset = 0; offset < HL_SIZE; offset += 32) checksum += stm[offset] + nstm[offset];
+
+            start_time = std::chrono::steady_clock::now();
+            checksum += kernels->forward(*network, stm, nstm, cold_bucket);
+            (prefetch ? prefetched_ns : cold_ns) += elapsed_ns(start_time);
+        }
+
+        std::println("info string {} {} evals/s latency {} ns cold {} ns prefetched {} ns checksum {}", kernels->name,
+                     static_cast<uint64_t>(static_cast<double>(iterations) / throughput_ns * 1000000000.0),
+                     latency_ns / static_cast<int64_t>(iterations), cold_ns / static_cast<int64_t>(cold_iterations),
+                     prefetched_ns / static_cast<int64_t>(cold_iterations), checksum);
+    }
+
+    const uint64_t refresh_iterations = std::max<uint64_t>(1, iterations / 100);
+    const auto start_time = std::chrono::steady_clock::now();
+
+    for (uint64_t i = 0; i < refresh_iterations; i++)
+    {
+        accumulators_set(*network, pos.boards, accumulator_stack[0].accumulators);
+    }
+
+    std::println("info string refresh {} ns per call with {} pieces using {}",
+                 elapsed_ns(start_time) / static_cast<int64_t>(refresh_iterations),
+                 std::popcount(pos.occupations[2]), NNUE::kernels.name);
+}
+
+static std::vector<unsigned char> encode_network(const Network& net, const NetFormat format)
+{
+    NetHeader header{};
+    std::memcpy(header.magic, net_magic, sizeof(net_magic));
+    header.version = net_version;
+    header.format = format;
+    header.input_buckets = INPUT_BUCKETS;
+    header.input_size = INPUT_SIZE;
+    header.hl_size = HL_SIZE;
+    header.output_buckets = OUTPUT_BUCKETS;
+
+    static constexpr size_t weight_count = sizeof(Network::accumulator_weights) / sizeof(int16_t);
+    const auto weights = &net.accumulator_weights[0][0][0];
+
+    if (format == NetFormat::int8)
+    {
+        int max_weight = 0;
+        for (size_t i = 0; i < weight_count; i++) max_weight = std::max(max_weight, std::abs(weights[i]));
+        while (header.ft_shift < 8 && (max_weight + (1 << header.ft_shift >> 1)) >> header.ft_shift > 127)
+            header.ft_shift++;
+    }
+
+    std::vector<unsigned char> bytes(format == NetFormat::int8 ? int8_net_size : sizeof(header) + sizeof(Network));
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    const auto payload = bytes.data() + sizeof(header);
+
+    if (format == NetFormat::int16)
+    {
+        std::memcpy(payload, &net, sizeof(Network));
+        return bytes;
+    }
+
+    const int rounding = 1 << header.ft_shift >> 1;
+    for (size_t i = 0; i < weight_count; i++)
+    {
+        const int quantized = (weights[i] + rounding) >> header.ft_shift;
+        payload[i] = static_cast<unsigned char>(std::clamp(quantized, -128, 127));
+    }
+
+    std::memcpy(payload + weight_count, net.accumulator_biases, sizeof(Network) - sizeof(Network::accumulator_weights));
+    return bytes;
+}
+
+bool export_network(const std::string& path, const NetFormat format)
+{
+    const auto bytes = encode_network(*network, format);
+
+    Network* storage;
+    const Network* exported = decode_network(bytes.data(), bytes.size(), storage);
+    if (!exported) return false;
+
+    int64_t total_error = 0;
+    int max_error = 0;
+    for (const auto& fen : bench_positions)
+    {
+        Position pos;
+        State st;
+        fen_parse(pos, st, fen);
+
+        SIMD_ALIGN int16_t original[2 * HL_SIZE];
+        SIMD_ALIGN int16_t quantized[2 * HL_SIZE];
+        accumulators_set(*network, pos.boards, original);
+        accumulators_set(*exported, pos.boards, quantized);
+
+        const int error = std::abs(evaluate(*network, pos, original) - evaluate(*exported, pos, quantized));
+        total_error += error;
+        max_error = std::max(max_error, error);
+    }
+    std::free(storage);
+
+    std::println("info string {} net: {} bytes, eval error over {} positions: mean {:.2f} max {}",
+                 format == NetFormat::int8 ? "int8" : "int16", bytes.size(), bench_positions.size(),
+                 static_cast<double>(total_error) / bench_positions.size(), max_error);
+
+    const std::string temp_path = path + ".tmp";
+    std::FILE* file = std::fopen(temp_path.c_str(), "wb");
+    if (!file) return false;
+
+    const bool written = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    if (std::fclose(file) != 0 || !written)
+    {
+        std::remove(temp_path.c_str());
+        return false;
+    }
+
+    return std::rename(temp_path.c_str(), path.c_str()) == 0;
+}
@@ -1,9 +1,20 @@
 #pragma once
 
 #include <cstdint>
+#include <cstddef>
+#include <span>
+#include <string>
+
+#include "arch.hpp"
 
 struct Position;
 struct AccumulatorStack;
 
 void refresh_accumulators(const Position& pos, AccumulatorStack& accumulator_stack);
-int16_t eval(const Position& pos, AccumulatorStack& accumulator_stack);
\ No newline at end of file
+int16_t eval(const Position& pos, AccumulatorStack& accumulator_stack);
+void prefetch_output_weights(const Position& pos);
+void eval_batch(std::span<const Position> positions, std::span<int16_t> scores);
+void bench_forward(const Position& pos, AccumulatorStack& accumulator_stack, uint64_t iterations);
+bool load_network(const unsigned char* bytes, size_t size);
+bool load_network_file(const std::string& path, const std::string& cache_dir);
+bool export_network(const std::string& path, NetFormat format);
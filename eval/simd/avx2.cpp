@@ -1,19 +1,29 @@
-#if defined(__AVX2__) && !defined(__AVX512F__)
+#ifdef __AVX2__
 
 #include <immintrin.h>
 
 #include "../arch.hpp"
 #include "simd.hpp"
 
-namespace NNUE
+namespace NNUE::AVX2
 {
-    int32_t forward(const Network& __restrict network, int16_t* __restrict stm, int16_t* __restrict nstm, const uint8_t bucket)
+    static int32_t reduce_add(const __m256i sum)
+    {
+        const __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        const auto high64 = _mm_unpackhi_epi64(sum128, sum128);
+        const auto sum64 = _mm_add_epi32(high64, sum128);
+        const auto high32 = _mm_shufflelo_epi16(sum64, 0x4e);
+        const auto sum32 = _mm_add_epi32(sum64, high32);
+        return _mm_cvtsi128_si32(sum32);
+    }
+
+    int32_t forward(const Network& __restrict network, const int16_t* __restrict stm, const int16_t* __restrict nstm, const uint8_t bucket)
     {
         static const __m256i vec_zero = _mm256_setzero_si256();
         static const __m256i vec_QA = _mm256_set1_epi16(QA);
 
-        auto to_move = reinterpret_cast<__m256i*>(stm);
-        auto not_to_move = reinterpret_cast<__m256i*>(nstm);
+        auto to_move = reinterpret_cast<const __m256i*>(stm);
+        auto not_to_move = reinterpret_cast<const __m256i*>(nstm);
         auto move_weights = reinterpret_cast<const __m256i*>(&network.output_weights[bucket]);
         auto non_move_weights = reinterpret_cast<const __m256i*>(&network.output_weights[bucket][HL_SIZE]);
 
@@ -37,12 +47,237 @@ namespace NNUE
             sum = _mm256_add_epi32(sum, them_results);
         }
 
-        const __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
-        const auto high64 = _mm_unpackhi_epi64(sum128, sum128);
-        const auto sum64 = _mm_add_epi32(high64, sum128);
-        const auto high32 = _mm_shufflelo_epi16(sum64, 0x4e);
-        const auto sum32 = _mm_add_epi32(sum64, high32);
-        return _mm_cvtsi128_si32(sum32);
+        return reduce_add(sum);
+    }
+
+    void forward_batch(const Network& __restrict network, const int16_t* const* stm, const int16_t* const* nstm,
+                       const int count, const uint8_t bucket, int32_t* results)
+    {
+        static const __m256i vec_zero = _mm256_setzero_si256();
+        static const __m256i vec_QA = _mm256_set1_epi16(QA);
+        static_assert(forward_batch_size == 4);
+
+        auto move_weights = reinterpret_cast<const __m256i*>(&network.output_weights[bucket]);
+        auto non_move_weights = reinterpret_cast<const __m256i*>(&network.output_weights[bucket][HL_SIZE]);
+
+        const __m256i* to_move[forward_batch_size];
+        const __m256i* not_to_move[forward_batch_size];
+        for (int p = 0; p < forward_batch_size; p++)
+        {
+            to_move[p] = reinterpret_cast<const __m256i*>(stm[p < count ? p : 0]);
+            not_to_move[p] = reinterpret_cast<const __m256i*>(nstm[p < count ? p : 0]);
+        }
+
+        __m256i sum0 = vec_zero;
+        __m256i sum1 = vec_zero;
+        __m256i sum2 = vec_zero;
+        __m256i sum3 = vec_zero;
+
+        auto screlu_dot = [](const __m256i weights, const __m256i us, const __m256i them_weights, const __m256i them)
+        {
+            const __m256i us_clamped = _mm256_min_epi16(_mm256_max_epi16(us, vec_zero), vec_QA);
+            const __m256i them_clamped = _mm256_min_epi16(_mm256_max_epi16(them, vec_zero), vec_QA);
+            return _mm256_add_epi32(_mm256_madd_epi16(_mm256_mullo_epi16(weights, us_clamped), us_clamped),
+                                    _mm256_madd_epi16(_mm256_mullo_epi16(them_weights, them_clamped), them_clamped));
+        };
+
+        static constexpr int iters = HL_SIZE / 16;
+
+        for (int i = 0; i < iters; i++)
+        {
+            const __m256i us_weights = _mm256_load_si256(&move_weights[i]);
+            const __m256i them_weights = _mm256_load_si256(&non_move_weights[i]);
+
+            sum0 = _mm256_add_epi32(sum0, screlu_dot(us_weights, _mm256_load_si256(&to_move[0][i]),
+                                                     them_weights, _mm256_load_si256(&not_to_move[0][i])));
+            sum1 = _mm256_add_epi32(sum1, screlu_dot(us_weights, _mm256_load_si256(&to_move[1][i]),
+                                                     them_weights, _mm256_load_si256(&not_to_move[1][i])));
+            sum2 = _mm256_add_epi32(sum2, screlu_dot(us_weights, _mm256_load_si256(&to_move[2][i]),
+                                                     them_weights, _mm256_load_si256(&not_to_move[2][i])));
+            sum3 = _mm256_add_epi32(sum3, screlu_dot(us_weights, _mm256_load_si256(&to_move[3][i]),
+                                                     them_weights, _mm256_load_si256(&not_to_move[3][i])));
+        }
+
+        const int32_t totals[forward_batch_size] = {reduce_add(sum0), reduce_add(sum1), reduce_add(sum2), reduce_add(sum3)};
+        for (int p = 0; p < count; p++) results[p] = totals[p];
+    }
+
+    [[gnu::target("avxvnni")]]
+    int32_t forward_vnni(const Network& __restrict network, const int16_t* __restrict stm, const int16_t* __restrict nstm, const uint8_t bucket)
+    {
+        static const __m256i vec_zero = _mm256_setzero_si256();
+        static const __m256i vec_QA = _mm256_set1_epi16(QA);
+
+        auto to_move = reinterpret_cast<const __m256i*>(stm);
+        auto not_to_move = reinterpret_cast<const __m256i*>(nstm);
+        auto move_weights = reinterpret_cast<const __m256i*>(&network.output_weights[bucket]);
+        auto non_move_weights = reinterpret_cast<const __m256i*>(&network.output_weights[bucket][HL_SIZE]);
+
+        __m256i us_sum0 = vec_zero;
+        __m256i us_sum1 = vec_zero;
+        __m256i them_sum0 = vec_zero;
+        __m256i them_sum1 = vec_zero;
+
+        auto clamp = [](const __m256i value)
+        {
+            return _mm256_min_epi16(_mm256_max_epi16(value, vec_zero), vec_QA);
+        };
+
+        static constexpr int iters = HL_SIZE / 16;
+        static_assert(iters % 2 == 0);
+
+        for (int i = 0; i < iters; i += 2)
+        {
+            const __m256i us0 = clamp(_mm256_load_si256(&to_move[i]));
+            const __m256i us1 = clamp(_mm256_load_si256(&to_move[i + 1]));
+            const __m256i them0 = clamp(_mm256_load_si256(&not_to_move[i]));
+            const __m256i them1 = clamp(_mm256_load_si256(&not_to_move[i + 1]));
+
+            us_sum0 = _mm256_dpwssd_avx_epi32(us_sum0, _mm256_mullo_epi16(_mm256_load_si256(&move_weights[i]), us0), us0);
+            us_sum1 = _mm256_dpwssd_avx_epi32(us_sum1, _mm256_mullo_epi16(_mm256_load_si256(&move_weights[i + 1]), us1), us1);
+            them_sum0 = _mm256_dpwssd_avx_epi32(them_sum0, _mm256_mullo_epi16(_mm256_load_si256(&non_move_weights[i]), them0), them0);
+            them_sum1 = _mm256_dpwssd_avx_epi32(them_sum1, _mm256_mullo_epi16(_mm256_load_si256(&non_move_weights[i + 1]), them1), them1);
+        }
+
+        const __m256i sum = _mm256_add_epi32(_mm256_add_epi32(us_sum0, us_sum1), _mm256_add_epi32(them_sum0, them_sum1));
+
+        return reduce_add(sum);
+    }
+
+    static constexpr int tile_registers = 10;
+    static constexpr int tile_size = tile_registers * 16;
+    static_assert(HL_SIZE % tile_size == 0);
+
+    void addsub(const int16_t* __restrict prev, int16_t* __restrict accumulator,
+                const int16_t* __restrict add, const int16_t* __restrict sub)
+    {
+        for (int offset = 0; offset < HL_SIZE; offset += tile_size)
+        {
+            const auto prev_tile = reinterpret_cast<const __m256i*>(&prev[offset]);
+            const auto add_tile = reinterpret_cast<const __m256i*>(&add[offset]);
+            const auto sub_tile = reinterpret_cast<const __m256i*>(&sub[offset]);
+            const auto out_tile = reinterpret_cast<__m256i*>(&accumulator[offset]);
+
+            __m256i registers[tile_registers];
+            #pragma GCC unroll tile_registers
+            for (int i = 0; i < tile_registers; i++)
+            {
+                registers[i] = _mm256_load_si256(&prev_tile[i]);
+                registers[i] = _mm256_add_epi16(registers[i], _mm256_load_si256(&add_tile[i]));
+                registers[i] = _mm256_sub_epi16(registers[i], _mm256_load_si256(&sub_tile[i]));
+            }
+            #pragma GCC unroll tile_registers
+            for (int i = 0; i < tile_registers; i++) _mm256_store_si256(&out_tile[i], registers[i]);
+        }
+    }
+
+    void addsub2(const int16_t* __restrict prev, int16_t* __restrict accumulator,
+                 const int16_t* __restrict add, const int16_t* __restrict sub1, const int16_t* __restrict sub2)
+    {
+        for (int offset = 0; offset < HL_SIZE; offset += tile_size)
+        {
+            const auto prev_tile = reinterpret_cast<const __m256i*>(&prev[offset]);
+            const auto add_tile = reinterpret_cast<const __m256i*>(&add[offset]);
+            const auto sub1_tile = reinterpret_cast<const __m256i*>(&sub1[offset]);
+            const auto sub2_tile = reinterpret_cast<const __m256i*>(&sub2[offset]);
+            const auto out_tile = reinterpret_cast<__m256i*>(&accumulator[offset]);
+
+            __m256i registers[tile_registers];
+            #pragma GCC unroll tile_registers
+            for (int i = 0; i < tile_registers; i++)
+            {
+                registers[i] = _mm256_load_si256(&prev_tile[i]);
+                registers[i] = _mm256_add_epi16(registers[i], _mm256_load_si256(&add_tile[i]));
+                registers[i] = _mm256_sub_epi16(registers[i], _mm256_load_si256(&sub1_tile[i]));
+                registers[i] = _mm256_sub_epi16(registers[i], _mm256_load_si256(&sub2_tile[i]));
+            }
+            #pragma GCC unroll tile_registers
+            for (int i = 0; i < tile_registers; i++) _mm256_store_si256(&out_tile[i], registers[i]);
+        }
+    }
+
+    void add2sub2(const int16_t* __restrict prev, int16_t* __restrict accumulator,
+                  const int16_t* __restrict add1, const int16_t* __restrict add2,
+                  const int16_t* __restrict sub1, const int16_t* __restrict sub2)
+    {
+        for (int offset = 0; offset < HL_SIZE; offset += tile_size)
+        {
+            const auto prev_tile = reinterpret_cast<const __m256i*>(&prev[offset]);
+            const auto add1_tile = reinterpret_cast<const __m256i*>(&add1[offset]);
+            const auto add2_tile = reinterpret_cast<const __m256i*>(&add2[offset]);
+            const auto sub1_tile = reinterpret_cast<const __m256i*>(&sub1[offset]);
+            const auto sub2_tile = reinterpret_cast<const __m256i*>(&sub2[offset]);
+            const auto out_tile = reinterpret_cast<__m256i*>(&accumulator[offset]);
+
+            __m256i registers[tile_registers];
+            #pragma GCC unroll tile_registers
+            for (int i = 0; i < tile_registers; i++)
+            {
+                registers[i] = _mm256_load_si256(&prev_tile[i]);
+                registers[i] = _mm256_add_epi16(registers[i], _mm256_load_si256(&add1_tile[i]));
+                registers[i] = _mm256_add_epi16(registers[i], _mm256_load_si256(&add2_tile[i]));
+                registers[i] = _mm256_sub_epi16(registers[i], _mm256_load_si256(&sub1_tile[i]));
+                registers[i] = _mm256_sub_epi16(registers[i], _mm256_load_si256(&sub2_tile[i]));
+            }
+            #pragma GCC unroll tile_registers
+            for (int i = 0; i < tile_registers; i++) _mm256_store_si256(&out_tile[i], registers[i]);
+        }
+    }
+
+    void apply_features(const int16_t* input, int16_t* output, const int16_t* const* adds, const int add_count,
+                        const int16_t* const* subs, const int sub_count)
+    {
+        for (int offset = 0; offset < HL_SIZE; offset += tile_size)
+        {
+            const auto in_tile = reinterpret_cast<const __m256i*>(&input[offset]);
+            const auto out_tile = reinterpret_cast<__m256i*>(&output[offset]);
+
+            __m256i registers[tile_registers];
+            #pragma GCC unroll tile_registers
+            for (int i = 0; i < tile_registers; i++) registers[i] = _mm256_load_si256(&in_tile[i]);
+
+            for (int feature = 0; feature < add_count; feature++)
+            {
+                const auto row = reinterpret_cast<const __m256i*>(&adds[feature][offset]);
+                #pragma GCC unroll tile_registers
+                for (int i = 0; i < tile_registers; i++)
+                    registers[i] = _mm256_add_epi16(registers[i], _mm256_load_si256(&row[i]));
+            }
+
+            for (int feature = 0; feature < sub_count; feature++)
+            {
+                const auto row = reinterpret_cast<const __m256i*>(&subs[feature][offset]);
+                #pragma GCC unroll tile_registers
+                for (int i = 0; i < tile_registers; i++)
+                    registers[i] = _mm256_sub_epi16(registers[i], _mm256_load_si256(&row[i]));
+            }
+
+            #pragma GCC unroll tile_registers
+            for (int i = 0; i < tile_registers; i++) _mm256_store_si256(&out_tile[i], registers[i]);
+        }
     }
 }
+
+namespace NNUE
+{
+    static constexpr Kernels avx2_table = {
+        "avx2", AVX2::forward, AVX2::forward_batch, AVX2::addsub, AVX2::addsub2, AVX2::add2sub2, AVX2::apply_features
+    };
+
+    static constexpr Kernels avx_vnni_table = {
+        "avx-vnni", AVX2::forward_vnni, AVX2::forward_batch, AVX2::addsub, AVX2::addsub2, AVX2::add2sub2, AVX2::apply_features
+    };
+
+    const Kernels* const avx2_kernels = &avx2_table;
+    const Kernels* const avx_vnni_kernels = &avx_vnni_table;
+}
+
+#else
+
+#include "../arch.hpp"
+#include "simd.hpp"
+
+const NNUE::Kernels* const NNUE::avx2_kernels = nullptr;
+const NNUE::Kernels* const NNUE::avx_vnni_kernels = nullptr;
+
 #endif
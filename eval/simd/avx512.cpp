@@ -5,15 +5,15 @@
 #include "../arch.hpp"
 #include "simd.hpp"
 
-namespace NNUE
+namespace NNUE::AVX512
 {
-    int32_t forward(const Network& __restrict network, int16_t* __restrict stm, int16_t* __restrict nstm, const uint8_t bucket)
+    int32_t forward(const Network& __restrict network, const int16_t* __restrict stm, const int16_t* __restrict nstm, const uint8_t bucket)
     {
         static const __m512i vec_zero = _mm512_setzero_si512();
         static const __m512i vec_QA = _mm512_set1_epi16(QA);
 
-        auto to_move = reinterpret_cast<__m512i*>(stm);
-        auto not_to_move = reinterpret_cast<__m512i*>(nstm);
+        auto to_move = reinterpret_cast<const __m512i*>(stm);
+        auto not_to_move = reinterpret_cast<const __m512i*>(nstm);
         auto move_weights = reinterpret_cast<const __m512i*>(&network.output_weights[bucket]);
         auto non_move_weights = reinterpret_cast<const __m512i*>(&network.output_weights[bucket][HL_SIZE]);
 
@@ -40,6 +40,238 @@ namespace NNUE
 
         return _mm512_reduce_add_epi32(sum);
     }
+
+    void forward_batch(const Network& __restrict network, const int16_t* const* stm, const int16_t* const* nstm,
+                       const int count, const uint8_t bucket, int32_t* results)
+    {
+        static const __m512i vec_zero = _mm512_setzero_si512();
+        static const __m512i vec_QA = _mm512_set1_epi16(QA);
+        static_assert(forward_batch_size == 4);
+
+        auto move_weights = reinterpret_cast<const __m512i*>(&network.output_weights[bucket]);
+        auto non_move_weights = reinterpret_cast<const __m512i*>(&network.output_weights[bucket][HL_SIZE]);
+
+        const __m512i* to_move[forward_batch_size];
+        const __m512i* not_to_move[forward_batch_size];
+        for (int p = 0; p < forward_batch_size; p++)
+        {
+            to_move[p] = reinterpret_cast<const __m512i*>(stm[p < count ? p : 0]);
+            not_to_move[p] = reinterpret_cast<const __m512i*>(nstm[p < count ? p : 0]);
+        }
+
+        __m512i sum0 = vec_zero;
+        __m512i sum1 = vec_zero;
+        __m512i sum2 = vec_zero;
+        __m512i sum3 = vec_zero;
+
+        auto screlu_dot = [](const __m512i weights, const __m512i us, const __m512i them_weights, const __m512i them)
+        {
+            const __m512i us_clamped = _mm512_min_epi16(_mm512_max_epi16(us, vec_zero), vec_QA);
+            const __m512i them_clamped = _mm512_min_epi16(_mm512_max_epi16(them, vec_zero), vec_QA);
+            return _mm512_add_epi32(_mm512_madd_epi16(_mm512_mullo_epi16(weights, us_clamped), us_clamped),
+                                    _mm512_madd_epi16(_mm512_mullo_epi16(them_weights, them_clamped), them_clamped));
+        };
+
+        static constexpr int iters = HL_SIZE / 32;
+
+        for (int i = 0; i < iters; i++)
+        {
+            const __m512i us_weights = _mm512_load_si512(&move_weights[i]);
+            const __m512i them_weights = _mm512_load_si512(&non_move_weights[i]);
+
+            sum0 = _mm512_add_epi32(sum0, screlu_dot(us_weights, _mm512_load_si512(&to_move[0][i]),
+                                                     them_weights, _mm512_load_si512(&not_to_move[0][i])));
+            sum1 = _mm512_add_epi32(sum1, screlu_dot(us_weights, _mm512_load_si512(&to_move[1][i]),
+                                                     them_weights, _mm512_load_si512(&not_to_move[1][i])));
+            sum2 = _mm512_add_epi32(sum2, screlu_dot(us_weights, _mm512_load_si512(&to_move[2][i]),
+                                                     them_weights, _mm512_load_si512(&not_to_move[2][i])));
+            sum3 = _mm512_add_epi32(sum3, screlu_dot(us_weights, _mm512_load_si512(&to_move[3][i]),
+                                                     them_weights, _mm512_load_si512(&not_to_move[3][i])));
+        }
+
+        const int32_t totals[forward_batch_size] = {
+            _mm512_reduce_add_epi32(sum0), _mm512_reduce_add_epi32(sum1),
+            _mm512_reduce_add_epi32(sum2), _mm512_reduce_add_epi32(sum3)
+        };
+        for (int p = 0; p < count; p++) results[p] = totals[p];
+    }
+
+    [[gnu::target("avx512vnni")]]
+    int32_t forward_vnni(const Network& __restrict network, const int16_t* __restrict stm, const int16_t* __restrict nstm, const uint8_t bucket)
+    {
+        static const __m512i vec_zero = _mm512_setzero_si512();
+        static const __m512i vec_QA = _mm512_set1_epi16(QA);
+
+        auto to_move = reinterpret_cast<const __m512i*>(stm);
+        auto not_to_move = reinterpret_cast<const __m512i*>(nstm);
+        auto move_weights = reinterpret_cast<const __m512i*>(&network.output_weights[bucket]);
+        auto non_move_weights = reinterpret_cast<const __m512i*>(&network.output_weights[bucket][HL_SIZE]);
+
+        __m512i us_sum0 = vec_zero;
+        __m512i us_sum1 = vec_zero;
+        __m512i them_sum0 = vec_zero;
+        __m512i them_sum1 = vec_zero;
+
+        auto clamp = [](const __m512i value)
+        {
+            return _mm512_min_epi16(_mm512_max_epi16(value, vec_zero), vec_QA);
+        };
+
+        static constexpr int iters = HL_SIZE / 32;
+        static_assert(iters % 2 == 0);
+
+        for (int i = 0; i < iters; i += 2)
+        {
+            const __m512i us0 = clamp(_mm512_load_si512(&to_move[i]));
+            const __m512i us1 = clamp(_mm512_load_si512(&to_move[i + 1]));
+            const __m512i them0 = clamp(_mm512_load_si512(&not_to_move[i]));
+            const __m512i them1 = clamp(_mm512_load_si512(&not_to_move[i + 1]));
+
+            us_sum0 = _mm512_dpwssd_epi32(us_sum0, _mm512_mullo_epi16(_mm512_load_si512(&move_weights[i]), us0), us0);
+            us_sum1 = _mm512_dpwssd_epi32(us_sum1, _mm512_mullo_epi16(_mm512_load_si512(&move_weights[i + 1]), us1), us1);
+            them_sum0 = _mm512_dpwssd_epi32(them_sum0, _mm512_mullo_epi16(_mm512_load_si512(&non_move_weights[i]), them0), them0);
+            them_sum1 = _mm512_dpwssd_epi32(them_sum1, _mm512_mullo_epi16(_mm512_load_si512(&non_move_weights[i + 1]), them1), them1);
+        }
+
+        const __m512i sum = _mm512_add_epi32(_mm512_add_epi32(us_sum0, us_sum1), _mm512_add_epi32(them_sum0, them_sum1));
+
+        return _mm512_reduce_add_epi32(sum);
+    }
+
+    static constexpr int tile_registers = 20;
+    static constexpr int tile_size = tile_registers * 32;
+    static_assert(HL_SIZE % tile_size == 0);
+
+    void addsub(const int16_t* __restrict prev, int16_t* __restrict accumulator,
+                const int16_t* __restrict add, const int16_t* __restrict sub)
+    {
+        for (int offset = 0; offset < HL_SIZE; offset += tile_size)
+        {
+            const auto prev_tile = reinterpret_cast<const __m512i*>(&prev[offset]);
+            const auto add_tile = reinterpret_cast<const __m512i*>(&add[offset]);
+            const auto sub_tile = reinterpret_cast<const __m512i*>(&sub[offset]);
+            const auto out_tile = reinterpret_cast<__m512i*>(&accumulator[offset]);
+
+            __m512i registers[tile_registers];
+            #pragma GCC unroll tile_registers
+            for (int i = 0; i < tile_registers; i++)
+            {
+                registers[i] = _mm512_load_si512(&prev_tile[i]);
+                registers[i] = _mm512_add_epi16(registers[i], _mm512_load_si512(&add_tile[i]));
+                registers[i] = _mm512_sub_epi16(registers[i], _mm512_load_si512(&sub_tile[i]));
+            }
+            #pragma GCC unroll tile_registers
+            for (int i = 0; i < tile_registers; i++) _mm512_store_si512(&out_tile[i], registers[i]);
+        }
+    }
+
+    void addsub2(const int16_t* __restrict prev, int16_t* __restrict accumulator,
+                 const int16_t* __restrict add, const int16_t* __restrict sub1, const int16_t* __restrict sub2)
+    {
+        for (int offset = 0; offset < HL_SIZE; offset += tile_size)
+        {
+            const auto prev_tile = reinterpret_cast<const __m512i*>(&prev[offset]);
+            const auto add_tile = reinterpret_cast<const __m512i*>(&add[offset]);
+            const auto sub1_tile = reinterpret_cast<const __m512i*>(&sub1[offset]);
+            const auto sub2_tile = reinterpret_cast<const __m512i*>(&sub2[offset]);
+            const auto out_tile = reinterpret_cast<__m512i*>(&accumulator[offset]);
+
+            __m512i registers[tile_registers];
+            #pragma GCC unroll tile_registers
+            for (int i = 0; i < tile_registers; i++)
+            {
+                registers[i] = _mm512_load_si512(&prev_tile[i]);
+                registers[i] = _mm512_add_epi16(registers[i], _mm512_load_si512(&add_tile[i]));
+                registers[i] = _mm512_sub_epi16(registers[i], _mm512_load_si512(&sub1_tile[i]));
+                registers[i] = _mm512_sub_epi16(registers[i], _mm512_load_si512(&sub2_tile[i]));
+            }
+            #pragma GCC unroll tile_registers
+            for (int i = 0; i < tile_registers; i++) _mm512_store_si512(&out_tile[i], registers[i]);
+        }
+    }
+
+    void add2sub2(const int16_t* __restrict prev, int16_t* __restrict accumulator,
+                  const int16_t* __restrict add1, const int16_t* __restrict add2,
+                  const int16_t* __restrict sub1, const int16_t* __restrict sub2)
+    {
+        for (int offset = 0; offset < HL_SIZE; offset += tile_size)
+        {
+            const auto prev_tile = reinterpret_cast<const __m512i*>(&prev[offset]);
+            const auto add1_tile = reinterpret_cast<const __m512i*>(&add1[offset]);
+            const auto add2_tile = reinterpret_cast<const __m512i*>(&add2[offset]);
+            const auto sub1_tile = reinterpret_cast<const __m512i*>(&sub1[offset]);
+            const auto sub2_tile = reinterpret_cast<const __m512i*>(&sub2[offset]);
+            const auto out_tile = reinterpret_cast<__m512i*>(&accumulator[offset]);
+
+            __m512i registers[tile_registers];
+            #pragma GCC unroll tile_registers
+            for (int i = 0; i < tile_registers; i++)
+            {
+                registers[i] = _mm512_load_si512(&prev_tile[i]);
+                registers[i] = _mm512_add_epi16(registers[i], _mm512_load_si512(&add1_tile[i]));
+                registers[i] = _mm512_add_epi16(registers[i], _mm512_load_si512(&add2_tile[i]));
+                registers[i] = _mm512_sub_epi16(registers[i], _mm512_load_si512(&sub1_tile[i]));
+                registers[i] = _mm512_sub_epi16(registers[i], _mm512_load_si512(&sub2_tile[i]));
+            }
+            #pragma GCC unroll tile_registers
+            for (int i = 0; i < tile_registers; i++) _mm512_store_si512(&out_tile[i], registers[i]);
+        }
+    }
+
+    void apply_features(const int16_t* input, int16_t* output, const int16_t* const* adds, const int add_count,
+                        const int16_t* const* subs, const int sub_count)
+    {
+        for (int offset = 0; offset < HL_SIZE; offset += tile_size)
+        {
+            const auto in_tile = reinterpret_cast<const __m512i*>(&input[offset]);
+            const auto out_tile = reinterpret_cast<__m512i*>(&output[offset]);
+
+            __m512i registers[tile_registers];
+            #pragma GCC unroll tile_registers
+            for (int i = 0; i < tile_registers; i++) registers[i] = _mm512_load_si512(&in_tile[i]);
+
+            for (int feature = 0; feature < add_count; feature++)
+            {
+                const auto row = reinterpret_cast<const __m512i*>(&adds[feature][offset]);
+                #pragma GCC unroll tile_registers
+                for (int i = 0; i < tile_registers; i++)
+                    registers[i] = _mm512_add_epi16(registers[i], _mm512_load_si512(&row[i]));
+            }
+
+            for (int feature = 0; feature < sub_count; feature++)
+            {
+                const auto row = reinterpret_cast<const __m512i*>(&subs[feature][offset]);
+                #pragma GCC unroll tile_registers
+                for (int i = 0; i < tile_registers; i++)
+                    registers[i] = _mm512_sub_epi16(registers[i], _mm512_load_si512(&row[i]));
+            }
+
+            #pragma GCC unroll tile_registers
+            for (int i = 0; i < tile_registers; i++) _mm512_store_si512(&out_tile[i], registers[i]);
+        }
+    }
 }
 
-#endif
\ No newline at end of file
+namespace NNUE
+{
+    static constexpr Kernels avx512_table = {
+        "avx512", AVX512::forward, AVX512::forward_batch, AVX512::addsub, AVX512::addsub2, AVX512::add2sub2, AVX512::apply_features
+    };
+
+    static constexpr Kernels avx512_vnni_table = {
+        "avx512-vnni", AVX512::forward_vnni, AVX512::forward_batch, AVX512::addsub, AVX512::addsub2, AVX512::add2sub2, AVX512::apply_features
+    };
+
+    const Kernels* const avx512_kernels = &avx512_table;
+    const Kernels* const avx512_vnni_kernels = &avx512_vnni_table;
+}
+
+#else
+
+#include "../arch.hpp"
+#include "simd.hpp"
+
+const NNUE::Kernels* const NNUE::avx512_kernels = nullptr;
+const NNUE::Kernels* const NNUE::avx512_vnni_kernels = nullptr;
+
+#endif
@@ -0,0 +1,43 @@
+#include "simd.hpp"
+
+namespace NNUE
+{
+    std::vector<const Kernels*> supported_kernels()
+    {
+        std::vector<const Kernels*> supported;
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_cpu_init();
+
+        const bool avx512 = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+        const bool avx2 = __builtin_cpu_supports("avx2");
+
+        if (avx512_vnni_kernels && avx512 && __builtin_cpu_supports("avx512vnni"))
+            supported.push_back(avx512_vnni_kernels);
+
+        if (avx512_kernels && avx512)
+            supported.push_back(avx512_kernels);
+
+        if (avx_vnni_kernels && avx2 && __builtin_cpu_supports("avxvnni"))
+            supported.push_back(avx_vnni_kernels);
+
+        if (avx2_kernels && avx2)
+            supported.push_back(avx2_kernels);
+#endif
+        supported.push_back(scalar_kernels);
+        return supported;
+    }
+
+#ifdef NNUE_DISPATCH
+    Kernels kernels = *supported_kernels().front();
+#elif defined(__AVX512F__) && defined(__AVX512BW__) && defined(__AVX512VNNI__)
+    Kernels kernels = *avx512_vnni_kernels;
+#elif defined(__AVX512F__) && defined(__AVX512BW__)
+    Kernels kernels = *avx512_kernels;
+#elif defined(__AVX2__) && defined(__AVXVNNI__)
+    Kernels kernels = *avx_vnni_kernels;
+#elif defined(__AVX2__)
+    Kernels kernels = *avx2_kernels;
+#else
+    Kernels kernels = *scalar_kernels;
+#endif
+}
@@ -1,11 +1,9 @@
-#if !defined(__AVX512F__) && !defined(__AVX2__)
-
 #include <algorithm>
 
 #include "../arch.hpp"
 #include "simd.hpp"
 
-namespace NNUE
+namespace NNUE::Scalar
 {
     int32_t forward(const Network& __restrict network, const int16_t* __restrict stm, const int16_t* __restrict nstm, const uint8_t bucket)
     {
@@ -27,6 +25,59 @@ namespace NNUE
 
         return sum;
     }
+
+    void forward_batch(const Network& __restrict network, const int16_t* const* stm, const int16_t* const* nstm,
+                       const int count, const uint8_t bucket, int32_t* results)
+    {
+        for (int p = 0; p < count; p++) results[p] = forward(network, stm[p], nstm[p], bucket);
+    }
+
+    void addsub(const int16_t* __restrict prev, int16_t* __restrict accumulator,
+                const int16_t* __restrict add, const int16_t* __restrict sub)
+    {
+        for (int i = 0; i < HL_SIZE; i++)
+        {
+            accumulator[i] = static_cast<int16_t>(prev[i] + add[i] - sub[i]);
+        }
+    }
+
+    void addsub2(const int16_t* __restrict prev, int16_t* __restrict accumulator,
+                 const int16_t* __restrict add, const int16_t* __restrict sub1, const int16_t* __restrict sub2)
+    {
+        for (int i = 0; i < HL_SIZE; i++)
+        {
+            accumulator[i] = static_cast<int16_t>(prev[i] + add[i] - sub1[i] - sub2[i]);
+        }
+    }
+
+    void add2sub2(const int16_t* __restrict prev, int16_t* __restrict accumulator,
+                  const int16_t* __restrict add1, const int16_t* __restrict add2,
+                  const int16_t* __restrict sub1, const int16_t* __restrict sub2)
+    {
+        for (int i = 0; i < HL_SIZE; i++)
+        {
+            accumulator[i] = static_cast<int16_t>(prev[i] + add1[i] + add2[i] - sub1[i] - sub2[i]);
+        }
+    }
+
+    void apply_features(const int16_t* input, int16_t* output, const int16_t* const* adds, const int add_count,
+                        const int16_t* const* subs, const int sub_count)
+    {
+        for (int i = 0; i < HL_SIZE; i++)
+        {
+            int16_t value = input[i];
+            for (int feature = 0; feature < add_count; feature++) value = static_cast<int16_t>(value + adds[feature][i]);
+            for (int feature = 0; feature < sub_count; feature++) value = static_cast<int16_t>(value - subs[feature][i]);
+            output[i] = value;
+        }
+    }
 }
 
-#endif
\ No newline at end of file
+namespace NNUE
+{
+    static constexpr Kernels scalar_table = {
+        "scalar", Scalar::forward, Scalar::forward_batch, Scalar::addsub, Scalar::addsub2, Scalar::add2sub2, Scalar::apply_features
+    };
+
+    const Kernels* const scalar_kernels = &scalar_table;
+}
@@ -1,14 +1,182 @@
 #pragma once
 
-#ifdef __AVX512F__
+#include <cstdint>
+#include <vector>
+
+#include "../arch.hpp"
+
 #define SIMD_ALIGN alignas(64)
-#elifdef __AVX2__
-#define SIMD_ALIGN alignas(32)
-#else
-#define SIMD_ALIGN alignas(16)
-#endif
 
 namespace NNUE
 {
-    int32_t forward(const Network& __restrict network, int16_t* __restrict stm, int16_t* __restrict nstm, uint8_t bucket);
-}
\ No newline at end of file
+    // forward_batch scores up to this many positions sharing an output bucket, loading each weight vector once
+    static constexpr int forward_batch_size = 4;
+
+    struct Kernels
+    {
+        const char* name;
+        int32_t (*forward)(const Network& __restrict network, const int16_t* __restrict stm,
+                           const int16_t* __restrict nstm, uint8_t bucket);
+        void (*forward_batch)(const Network& __restrict network, const int16_t* const* stm, const int16_t* const* nstm,
+                              int count, uint8_t bucket, int32_t* results);
+        void (*addsub)(const int16_t* __restrict prev, int16_t* __restrict accumulator,
+                       const int16_t* __restrict add, const int16_t* __restrict sub);
+        void (*addsub2)(const int16_t* __restrict prev, int16_t* __restrict accumulator,
+                        const int16_t* __restrict add, const int16_t* __restrict sub1,
+                        const int16_t* __restrict sub2);
+        void (*add2sub2)(const int16_t* __restrict prev, int16_t* __restrict accumulator,
+                         const int16_t* __restrict add1, const int16_t* __restrict add2,
+                         const int16_t* __restrict sub1, const int16_t* __restrict sub2);
+        void (*apply_features)(const int16_t* input, int16_t* output, const int16_t* const* adds, int add_count,
+                               const int16_t* const* subs, int sub_count);
+    };
+
+    // per-ISA kernels, defined in the file compiled for that ISA
+    namespace AVX512
+    {
+        int32_t forward(const Network& __restrict network, const int16_t* __restrict stm,
+                        const int16_t* __restrict nstm, uint8_t bucket);
+        [[gnu::target("avx512vnni")]]
+        int32_t forward_vnni(const Network& __restrict network, const int16_t* __restrict stm,
+                             const int16_t* __restrict nstm, uint8_t bucket);
+        void forward_batch(const Network& __restrict network, const int16_t* const* stm, const int16_t* const* nstm,
+                           int count, uint8_t bucket, int32_t* results);
+        void addsub(const int16_t* __restrict prev, int16_t* __restrict accumulator,
+                    const int16_t* __restrict add, const int16_t* __restrict sub);
+        void addsub2(const int16_t* __restrict prev, int16_t* __restrict accumulator,
+                     const int16_t* __restrict add, const int16_t* __restrict sub1, const int16_t* __restrict sub2);
+        void add2sub2(const int16_t* __restrict prev, int16_t* __restrict accumulator,
+                      const int16_t* __restrict add1, const int16_t* __restrict add2,
+                      const int16_t* __restrict sub1, const int16_t* __restrict sub2);
+        void apply_features(const int16_t* input, int16_t* output, const int16_t* const* adds, int add_count,
+                            const int16_t* const* subs, int sub_count);
+    }
+
+    namespace AVX2
+    {
+        int32_t forward(const Network& __restrict network, const int16_t* __restrict stm,
+                        const int16_t* __restrict nstm, uint8_t bucket);
+        [[gnu::target("avxvnni")]]
+        int32_t forward_vnni(const Network& __restrict network, const int16_t* __restrict stm,
+                             const int16_t* __restrict nstm, uint8_t bucket);
+        void forward_batch(const Network& __restrict network, const int16_t* const* stm, const int16_t* const* nstm,
+                           int count, uint8_t bucket, int32_t* results);
+        void addsub(const int16_t* __restrict prev, int16_t* __restrict accumulator,
+                    const int16_t* __restrict add, const int16_t* __restrict sub);
+        void addsub2(const int16_t* __restrict prev, int16_t* __restrict accumulator,
+                     const int16_t* __restrict add, const int16_t* __restrict sub1, const int16_t* __restrict sub2);
+        void add2sub2(const int16_t* __restrict prev, int16_t* __restrict accumulator,
+                      const int16_t* __restrict add1, const int16_t* __restrict add2,
+                      const int16_t* __restrict sub1, const int16_t* __restrict sub2);
+        void apply_features(const int16_t* input, int16_t* output, const int16_t* const* adds, int add_count,
+                            const int16_t* const* subs, int sub_count);
+    }
+
+    namespace Scalar
+    {
+        int32_t forward(const Network& __restrict network, const int16_t* __restrict stm,
+                        const int16_t* __restrict nstm, uint8_t bucket);
+        void forward_batch(const Network& __restrict network, const int16_t* const* stm, const int16_t* const* nstm,
+                           int count, uint8_t bucket, int32_t* results);
+        void addsub(const int16_t* __restrict prev, int16_t* __restrict accumulator,
+                    const int16_t* __restrict add, const int16_t* __restrict sub);
+        void addsub2(const int16_t* __restrict prev, int16_t* __restrict accumulator,
+                     const int16_t* __restrict add, const int16_t* __restrict sub1, const int16_t* __restrict sub2);
+        void add2sub2(const int16_t* __restrict prev, int16_t* __restrict accumulator,
+                      const int16_t* __restrict add1, const int16_t* __restrict add2,
+                      const int16_t* __restrict sub1, const int16_t* __restrict sub2);
+        void apply_features(const int16_t* input, int16_t* output, const int16_t* const* adds, int add_count,
+                            const int16_t* const* subs, int sub_count);
+    }
+
+    extern const Kernels* const avx512_vnni_kernels;
+    extern const Kernels* const avx512_kernels;
+    extern const Kernels* const avx_vnni_kernels;
+    extern const Kernels* const avx2_kernels;
+    extern const Kernels* const scalar_kernels;
+
+    // the table in use; hot-path calls only go through it in dispatch builds
+    extern Kernels kernels;
+
+    std::vector<const Kernels*> supported_kernels();
+
+#ifndef NNUE_DISPATCH
+    // native builds call the kernels of the target ISA directly instead of through the table
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+    namespace Native = AVX512;
+#elif defined(__AVX2__)
+    namespace Native = AVX2;
+#else
+    namespace Native = Scalar;
+#endif
+
+#if defined(__AVX512F__) && defined(__AVX512BW__) && defined(__AVX512VNNI__)
+    inline constexpr auto& native_forward = AVX512::forward_vnni;
+#elif !(defined(__AVX512F__) && defined(__AVX512BW__)) && defined(__AVX2__) && defined(__AVXVNNI__)
+    inline constexpr auto& native_forward = AVX2::forward_vnni;
+#else
+    inline constexpr auto& native_forward = Native::forward;
+#endif
+#endif
+
+    inline int32_t forward(const Network& __restrict network, const int16_t* __restrict stm,
+                           const int16_t* __restrict nstm, const uint8_t bucket)
+    {
+#ifdef NNUE_DISPATCH
+        return kernels.forward(network, stm, nstm, bucket);
+#else
+        return native_forward(network, stm, nstm, bucket);
+#endif
+    }
+
+    inline void forward_batch(const Network& __restrict network, const int16_t* const* stm, const int16_t* const* nstm,
+                              const int count, const uint8_t bucket, int32_t* results)
+    {
+#ifdef NNUE_DISPATCH
+        kernels.forward_batch(network, stm, nstm, count, bucket, results);
+#else
+        Native::forward_batch(network, stm, nstm, count, bucket, results);
+#endif
+    }
+
+    inline void addsub(const int16_t* __restrict prev, int16_t* __restrict accumulator,
+                       const int16_t* __restrict add, const int16_t* __restrict sub)
+    {
+#ifdef NNUE_DISPATCH
+        kernels.addsub(prev, accumulator, add, sub);
+#else
+        Native::addsub(prev, accumulator, add, sub);
+#endif
+    }
+
+    inline void addsub2(const int16_t* __restrict prev, int16_t* __restrict accumulator,
+                        const int16_t* __restrict add, const int16_t* __restrict sub1, const int16_t* __restrict sub2)
+    {
+#ifdef NNUE_DISPATCH
+        kernels.addsub2(prev, accumulator, add, sub1, sub2);
+#else
+        Native::addsub2(prev, accumulator, add, sub1, sub2);
+#endif
+    }
+
+    inline void add2sub2(const int16_t* __restrict prev, int16_t* __restrict accumulator,
+                         const int16_t* __restrict add1, const int16_t* __restrict add2,
+                         const int16_t* __restrict sub1, const int16_t* __restrict sub2)
+    {
+#ifdef NNUE_DISPATCH
+        kernels.add2sub2(prev, accumulator, add1, add2, sub1, sub2);
+#else
+        Native::add2sub2(prev, accumulator, add1, add2, sub1, sub2);
+#endif
+    }
+
+    inline void apply_features(const int16_t* input, int16_t* output, const int16_t* const* adds, const int add_count,
+                               const int16_t* const* subs, const int sub_count)
+    {
+#ifdef NNUE_DISPATCH
+        kernels.apply_features(input, output, adds, add_count, subs, sub_count);
+#else
+        Native::apply_features(input, output, adds, add_count, subs, sub_count);
+#endif
+    }
+}
@@ -38,4 +38,16 @@ std::pair<uint8_t, uint8_t> get_buckets(const std::array<uint64_t, 14>& boards)
     return {
         input_buckets_map[lsb(boards[K]) ^ 56], input_buckets_map[lsb(boards[k])]
     };
-}
\ No newline at end of file
+}
+
+std::pair<uint8_t, uint8_t> get_buckets(const std::pair<uint8_t, uint8_t>& kings)
+{
+    return {
+        input_buckets_map[kings.first ^ 56], input_buckets_map[kings.second]
+    };
+}
+
+std::pair<uint8_t, uint8_t> king_squares(const std::array<uint64_t, 14>& boards)
+{
+    return {lsb(boards[K]), lsb(boards[k])};
+}
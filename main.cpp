@@ -6,9 +6,9 @@ int main(const int argc, char* argv[])
 {
     start();
 
-    if (argc > 1 && std::string_view(argv[1]) == "bench")
+    if (argc > 1 && (std::string_view(argv[1]) == "bench" || std::string_view(argv[1]) == "evalbatch"))
     {
-        const std::string bench_args = std::span(argv, argc)
+        const std::string args = std::span(argv, argc)
             | std::views::drop(1)
             | std::views::transform([](const char* ptr)
             {
@@ -17,7 +17,8 @@ int main(const int argc, char* argv[])
             | std::views::join_with(' ')
             | std::ranges::to<std::string>();
 
-        UCI::bench(bench_args);
+        if (std::string_view(argv[1]) == "bench") UCI::bench(args);
+        else UCI::eval_batch(args);
         return 0;
     }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <string>
 
 #define MAX_PLY 127
 
@@ -11,6 +12,9 @@ struct Options
     static inline int move_overhead{50};
     static inline bool verbose{false};
     static inline bool showcurrmove{false};
+    static inline std::string hash_file{};
+    static inline std::string eval_file{};
+    static inline std::string net_cache_dir{};
 };
 
 enum Values: int
@@ -1,4 +1,5 @@
 #include <cstdint>
+#include <bit>
 #include <charconv>
 #include <deque>
 
@@ -16,9 +17,8 @@ void setup_state(State& st)
     st.check_blocker = 0;
 }
 
-int fen_parse(Position& position, std::string_view fen)
+int fen_parse(Position& position, State& st, std::string_view fen)
 {
-    State st;
     setup_state(st);
     Position temp;
     temp.new_game();
@@ -254,17 +254,32 @@ int fen_parse(Position& position, std::string_view fen)
         boards[r];
     temp.occupations[2] = temp.occupations[white] | temp.occupations[black];
 
+    // the accumulator refresh gathers one feature row per piece into 32-entry buffers
+    if (std::popcount(temp.boards[K]) != 1 || std::popcount(temp.boards[k]) != 1 ||
+        std::popcount(temp.occupations[2]) > 32)
+    {
+        return -1;
+    }
+
     temp.get_checks();
     st.attacks = UINT64_MAX;
     st.pinned = UINT64_MAX;
 
     temp.construct_zobrist_key();
 
+    position = temp;
+
+    return 0;
+}
+
+int fen_parse(Position& position, const std::string_view fen)
+{
+    State st;
+    if (fen_parse(position, st, fen) == -1) return -1;
+
     ThreadPool::states.clear();
     ThreadPool::states.push_back(st);
-    temp.state = &ThreadPool::states.back();
-
-    position = temp;
+    position.state = &ThreadPool::states.back();
 
     return 0;
 }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #pragma once
 
 struct Position;
+struct State;
 
+int fen_parse(Position& position, State& st, std::string_view fen);
 int fen_parse(Position& position, std::string_view fen);
\ No newline at end of file
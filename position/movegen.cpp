@@ -46,7 +46,7 @@ void pawn_move_generator(const Position& cr_pos, Move*& pos)
 
     const uint64_t board = cr_pos.boards[board_index];
     const uint64_t check_blocker = cr_pos.state->checker ? cr_pos.state->check_blocker : 0ull;
-    const uint64_t pinned = cr_pos.state->pinned;
+    const uint64_t pinned = cr_pos.get_pinned();
 
     static constexpr int king = us == white ? K : k;
     const int king_sq = lsb(cr_pos.boards[king]);
@@ -203,6 +203,7 @@ void general_move_generator(const Position& cr_pos, Move*& pos)
 
     constexpr int king = us == white ? K : k;
     const int king_sq = lsb(cr_pos.boards[king]);
+    const uint64_t pinned = cr_pos.get_pinned();
     board = cr_pos.boards[board_index];
 
     while (board)
@@ -226,7 +227,7 @@ void general_move_generator(const Position& cr_pos, Move*& pos)
             movable = knight_attack_tables[from];
         }
 
-        if (cr_pos.state->pinned & (1ull << from))
+        if (pinned & (1ull << from))
         {
             if constexpr (piece == Knight) continue;
             movable &= lines_intersect[king_sq][from];
@@ -261,7 +262,7 @@ void king_move_generator(const Position& cr_pos, Move*& pos, const int king)
     const uint64_t eocc = cr_pos.occupations[!us];
     const uint64_t aocc = cr_pos.occupations[2];
 
-    const uint64_t enemy_threats = cr_pos.state->attacks;
+    const uint64_t enemy_threats = cr_pos.get_attacks();
     uint64_t movable = king_attack_tables[king] & ~enemy_threats & ~occ;
 
     uint64_t attacks = movable & eocc;
@@ -365,8 +366,6 @@ void pseudo_legals(const Position& cr_pos, MoveList& list)
 
 void legals(const Position& cr_pos, MoveList& list)
 {
-    cr_pos.fill_info();
-
     pseudo_legals<MoveType::all>(cr_pos, list);
     Move* current = list.begin();
 
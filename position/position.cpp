@@ -10,6 +10,7 @@
 #include "zobrist.hpp"
 #include "../board/attacks.hpp"
 #include "../search/thread.hpp"
+#include "../eval/utils.hpp"
 #include "../board/lines.hpp"
 #include "../board/slider.hpp"
 
@@ -61,7 +62,7 @@ void Position::remove_piece(const int sq)
     boards[piece] ^= board;
 }
 
-void Position::make_move(const Move move, State& st)
+void Position::make_move(const Move move, State& st, AccumulatorEntry* delta)
 {
     std::memcpy(&st, state, offsetof(State, key));
     st.previous = state;
@@ -77,6 +78,16 @@ void Position::make_move(const Move move, State& st)
 
     uint64_t key = st.previous->key ^ Zobrist::side_key ^ Zobrist::castling_keys[st.castling_rights];
 
+    if (delta)
+    {
+        delta->is_dirty = true;
+        delta->require_rebuild = false;
+        delta->adds[0] = {moving_piece, to};
+        delta->subs[0] = {moving_piece, from};
+        delta->adds[1] = {0, -1};
+        delta->subs[1] = {0, -1};
+    }
+
     if (captured_piece != nil)
     {
         auto captured_square = to;
@@ -129,6 +140,8 @@ void Position::make_move(const Move move, State& st)
 
         key ^= Zobrist::piece_keys[captured_piece][captured_square];
         st.rule_50 = 0;
+
+        if (delta) delta->subs[1] = {captured_piece, captured_square};
     }
     else
     {
@@ -140,12 +153,22 @@ void Position::make_move(const Move move, State& st)
             st.non_pawn_keys[side_to_move] ^= Zobrist::piece_keys[rook_piece][to + 1] ^ Zobrist::piece_keys[rook_piece][to - 1];
             st.major_key ^= Zobrist::piece_keys[rook_piece][to + 1] ^ Zobrist::piece_keys[rook_piece][to - 1];
             key ^= Zobrist::piece_keys[rook_piece][to + 1] ^ Zobrist::piece_keys[rook_piece][to - 1];
+            if (delta)
+            {
+                delta->adds[1] = {rook_piece, to - 1};
+                delta->subs[1] = {rook_piece, to + 1};
+            }
             break;
         case MoveFlag::queen_castle:
             move_piece(to - 2, to + 1);
             st.non_pawn_keys[side_to_move] ^= Zobrist::piece_keys[rook_piece][to - 2] ^ Zobrist::piece_keys[rook_piece][to + 1];
             st.major_key ^= Zobrist::piece_keys[rook_piece][to - 2] ^ Zobrist::piece_keys[rook_piece][to + 1];
             key ^= Zobrist::piece_keys[rook_piece][to - 2] ^ Zobrist::piece_keys[rook_piece][to + 1];
+            if (delta)
+            {
+                delta->adds[1] = {rook_piece, to + 1};
+                delta->subs[1] = {rook_piece, to - 2};
+            }
             break;
         default: break;
         }
@@ -175,6 +198,7 @@ void Position::make_move(const Move move, State& st)
             key ^= Zobrist::piece_keys[moving_piece][to] ^ Zobrist::piece_keys[promoted_to][to];
 
             if (type_of(promoted_to) >= Rook) st.major_key ^= Zobrist::piece_keys[promoted_to][to];
+            if (delta) delta->adds[0] = {promoted_to, to};
         }
         else if (flag == MoveFlag::double_push &&
             pawn_attack_tables[side_to_move][to + (side_to_move == white ? 8 : -8)] & boards[
@@ -233,6 +257,21 @@ void Position::make_move(const Move move, State& st)
 
     st.captured_piece = captured_piece;
 
+    if (delta)
+    {
+        delta->kings = king_squares(boards);
+
+        if (type_of(moving_piece) == King)
+        {
+            if (const int flip = (side_to_move == white) * 56;
+                input_buckets_map[from ^ flip] != input_buckets_map[to ^ flip] || ((from % 8 > 3) != (to % 8 > 3)))
+            {
+                delta->require_rebuild = true;
+                delta->bitboards = boards;
+            }
+        }
+    }
+
     side_to_move = !side_to_move;
 
     get_checks();
@@ -353,7 +392,7 @@ bool Position::is_pseudo_legal(const Move move) const
     const uint64_t to_board = 1ull << to;
     if (occupations[side_to_move] & to_board) return false;
 
-    if (state->pinned & (1ull << from))
+    if (get_pinned() & (1ull << from))
     {
         if (const auto king_board = boards[side_to_move == white ? K : k];
             !(lines_intersect[from][to] & king_board))
@@ -432,20 +471,20 @@ bool Position::is_pseudo_legal(const Move move) const
                 if (to != from + 2) return false;
                 if (!(state->castling_rights & (side_to_move == white ? white_king : black_king))) return false;
                 if (occupations[2] & king_path) return false;
-                if (state->attacks & king_path) return false;
+                if (get_attacks() & king_path) return false;
             }
             else
             {
                 if (to != from - 2) return false;
                 if (!(state->castling_rights & (side_to_move == white ? white_queen : black_queen))) return false;
                 if (occupations[2] & queen_path) return false;
-                if (state->attacks & queen_check_path) return false;
+                if (get_attacks() & queen_check_path) return false;
             }
             return true;
         }
 
         if (!(king_attack_tables[from] & to_board & ~occupations[side_to_move])) return false;
-        if (to_board & state->attacks) return false;
+        if (to_board & get_attacks()) return false;
     }
 
     if (state->checker)
@@ -632,23 +671,48 @@ void Position::construct_zobrist_key() const
     state->key ^= Zobrist::castling_keys[state->castling_rights];
 }
 
-void Position::get_pinned() const
+uint64_t Position::key_after(const Move move) const
 {
-    state->pinned = side_to_move == white ? get_pinned_board_of<white>() : get_pinned_board_of<black>();
+    const uint8_t from = move.from();
+    const uint8_t to = move.to();
+    const auto flag = move.flag();
+    const Piece moving_piece = piece_on[from];
+    const Piece placed_piece = flag >= MoveFlag::knight_promotion ? move.promoted_to(side_to_move) : moving_piece;
+
+    uint64_t key = state->key ^ Zobrist::side_key
+        ^ Zobrist::piece_keys[moving_piece][from] ^ Zobrist::piece_keys[placed_piece][to];
+
+    if (const Piece captured_piece = piece_on[to]; captured_piece != nil)
+    {
+        key ^= Zobrist::piece_keys[captured_piece][to];
+    }
+
+    if (state->en_passant_square != -1)
+    {
+        key ^= Zobrist::en_passant_key[state->en_passant_square % 8];
+    }
+
+    return key;
 }
 
-void Position::get_attacks() const
+// Pins and the enemy attack map are invalidated by make_move and only computed once something asks for them,
+// so nodes that cut off on the TT move never build them.
+uint64_t Position::get_pinned() const
 {
-    state->attacks = side_to_move == white ? get_attacked_map_of<white>() : get_attacked_map_of<black>();
+    if (state->pinned == UINT64_MAX)
+    {
+        state->pinned = side_to_move == white ? get_pinned_board_of<white>() : get_pinned_board_of<black>();
+    }
+    return state->pinned;
 }
 
-void Position::fill_info() const
+uint64_t Position::get_attacks() const
 {
     if (state->attacks == UINT64_MAX)
     {
-        get_attacks();
-        get_pinned();
+        state->attacks = side_to_move == white ? get_attacked_map_of<white>() : get_attacked_map_of<black>();
     }
+    return state->attacks;
 }
 
 void Position::get_checks() const
@@ -42,15 +42,14 @@ struct Position
     void put_piece(Piece piece, int sq);
     void remove_piece(int sq);
 
-    void make_move(Move move, State &st);
+    void make_move(Move move, State &st, AccumulatorEntry* delta = nullptr);
     void unmake_move(const Move &move);
     void do_move(Move move);
 
     void make_null_move(State& st);
     void unmake_null_move();
-    void fill_info() const;
-    void get_pinned() const;
-    void get_attacks() const;
+    [[nodiscard]] uint64_t get_pinned() const;
+    [[nodiscard]] uint64_t get_attacks() const;
     void get_checks() const;
 
     [[nodiscard]] bool upcoming_repetition(int ply) const;
@@ -72,6 +71,7 @@ struct Position
     [[nodiscard]] bool is_quiet(Move move) const;
 
     void construct_zobrist_key() const;
+    [[nodiscard]] uint64_t key_after(Move move) const;
 
     void print_board() const;
 
@@ -31,7 +31,7 @@ void Capture::apply(const bool stm, const uint8_t moved_piece, const uint8_t cap
         abs(clamped_bonus) / max_capture_history();
 }
 
-void Capture::update(const std::forward_list<CaptureEntry>& searched, const bool stm, uint8_t moved_piece,
+void Capture::update(const std::span<const CaptureEntry> searched, const bool stm, uint8_t moved_piece,
                      uint8_t captured_piece, const uint8_t sq, const uint8_t depth)
 {
     moved_piece &= 7;
@@ -53,7 +53,7 @@ void ButterflyHistory::apply(const bool side, const int from, const int to, cons
     table[side][from][to] += clamped_bonus - table[side][from][to] * abs(clamped_bonus) / max_butterfly_history();
 }
 
-void ButterflyHistory::update(const std::forward_list<Move>& searched, const bool side, const int from, const int to,
+void ButterflyHistory::update(const std::span<const Move> searched, const bool side, const int from, const int to,
                               const uint8_t depth)
 {
     const auto bonus = static_cast<int16_t>(butterfly_history_scale() * depth - butterfly_history_minus());
@@ -72,7 +72,7 @@ void PieceToHistory::apply(const bool side, const Piece piece, const int to, con
     table[side][piece][to] += clamped_bonus - table[side][piece][to] * abs(clamped_bonus) / max_piece_to_history();
 }
 
-void PieceToHistory::update(const Position& pos, const std::forward_list<Move>& searched, const bool side, Piece piece,
+void PieceToHistory::update(const Position& pos, const std::span<const Move> searched, const bool side, Piece piece,
                             const int to, const uint8_t depth)
 {
     piece = static_cast<Piece>(piece & 7);
@@ -99,7 +99,7 @@ void Continuation::apply(std::array<std::array<std::array<std::array<std::array<
         abs(clamped_bonus) / max_continuation_history();
 }
 
-void Continuation::update(const Position& pos, const std::forward_list<Move>& searched, const Move move,
+void Continuation::update(const Position& pos, const std::span<const Move> searched, const Move move,
                           const uint8_t depth, const SearchEntry* ss)
 {
     const auto bonus = static_cast<int16_t>(continuation_history_scale() * depth - continuation_history_minus());
@@ -219,7 +219,7 @@ void Corrections::update(const int delta, const Position& pos, const uint8_t dep
 
 void History::update_quiet_histories(const Position& pos, const int depth, const Move picked_move,
                                      const SearchEntry* ss,
-                                     const std::forward_list<Move>& quiets_searched)
+                                     const std::span<const Move> quiets_searched)
 {
     killers.insert(picked_move, ss->plies);
     butterfly_history.update(quiets_searched, pos.side_to_move, picked_move.from(), picked_move.to(),
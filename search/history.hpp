@@ -1,8 +1,9 @@
 #pragma once
 
 #include <cstdint>
-#include <forward_list>
+#include <cstddef>
 #include <array>
+#include <span>
 
 #include "../options.hpp"
 #include "../position/move.hpp"
@@ -33,16 +34,35 @@ struct CaptureEntry
     uint8_t captured;
     uint8_t sq;
 
+    CaptureEntry() = default;
     CaptureEntry(uint8_t _moved, uint8_t _captured, Move move);
 };
 
+// Moves searched at a node, kept on the stack. Filled from the back so the span lists the latest move first.
+template <typename T, size_t capacity>
+struct SearchedList
+{
+    std::array<T, capacity> items;
+    size_t first = capacity;
+
+    void push(const T& item)
+    {
+        items[--first] = item;
+    }
+
+    operator std::span<const T>() const
+    {
+        return {items.begin() + first, items.end()};
+    }
+};
+
 struct Capture
 {
     std::array<std::array<std::array<std::array<int16_t, 64>, 5>, 6>, 2> table;
 
     void apply(bool stm, uint8_t moved_piece, uint8_t captured_piece, int sq,
                int16_t bonus);
-    void update(const std::forward_list<CaptureEntry>& searched, bool stm, uint8_t moved_piece,
+    void update(std::span<const CaptureEntry> searched, bool stm, uint8_t moved_piece,
                 uint8_t captured_piece, uint8_t sq, uint8_t depth);
 };
 
@@ -51,7 +71,7 @@ struct ButterflyHistory
     std::array<std::array<std::array<int16_t, 64>, 64>, 2> table;
 
     void apply(bool side, int from, int to, int16_t bonus);
-    void update(const std::forward_list<Move>& searched, bool side, int from, int to,
+    void update(std::span<const Move> searched, bool side, int from, int to,
                 uint8_t depth);
 };
 
@@ -60,7 +80,7 @@ struct PieceToHistory
     std::array<std::array<std::array<int16_t, 64>, 6>, 2> table;
 
     void apply(bool side, Piece piece, int to, int16_t bonus);
-    void update(const Position& pos, const std::forward_list<Move>& searched, bool side, Piece piece,
+    void update(const Position& pos, std::span<const Move> searched, bool side, Piece piece,
                 int to, uint8_t depth);
 };
 
@@ -72,7 +92,7 @@ struct Continuation
     static void apply(std::array<std::array<std::array<std::array<std::array<int16_t, 64>, 6>, 64>, 6>, 2>& table,
                       bool stm, uint8_t prev_piece, uint8_t prev_to, uint8_t piece,
                       uint8_t to, int16_t bonus);
-    void update(const Position& pos, const std::forward_list<Move>& searched, Move move,
+    void update(const Position& pos, std::span<const Move> searched, Move move,
                 uint8_t depth, const SearchEntry* ss);
 };
 
@@ -104,6 +124,6 @@ struct History
     Killers killers;
 
     void update_quiet_histories(const Position& pos, int depth, Move picked_move, const SearchEntry* ss,
-                                const std::forward_list<Move>& quiets_searched);
+                                std::span<const Move> quiets_searched);
     void clear();
 };
@@ -12,8 +12,6 @@ MovePicker::MovePicker(SearchThread& _thread, const bool _noisy_only, const Move
     bad_captures_end = 255;
     threshold = _threshold;
 
-    thread.position.fill_info();
-
     if (const auto pv_flag = pv.flag(); _pv && thread.position.is_pseudo_legal(_pv)
         && !(noisy_only
             && pv_flag != MoveFlag::queen_promotion
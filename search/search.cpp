@@ -10,9 +10,19 @@
 #include "transposition.hpp"
 #include "../eval/nnue.hpp"
 
+static int cached_eval(SearchThread& thread)
+{
+    const uint64_t key = thread.position.state->key;
+    if (int16_t evaluation; thread.eval_cache.probe(key, evaluation)) return evaluation;
+
+    const int16_t evaluation = eval(thread.position, thread.accumulator_stack);
+    thread.eval_cache.store(key, evaluation);
+    return evaluation;
+}
+
 int quiesce(SearchThread& thread, int alpha, int beta, SearchEntry* ss)
 {
-    ++thread.node_searched;
+    thread.count_node();
     if (ss->plies > thread.seldepth)
     {
         thread.seldepth = ss->plies;
@@ -26,7 +36,7 @@ int quiesce(SearchThread& thread, int alpha, int beta, SearchEntry* ss)
     const bool not_in_check = !position.state->checker;
     if (ss->plies > MAX_PLY)
     {
-        return not_in_check ? eval(position, thread.accumulator_stack) : 0;
+        return not_in_check ? cached_eval(thread) : 0;
     }
 
     alpha = std::max(alpha, -mate_value + ss->plies);
@@ -42,7 +52,7 @@ int quiesce(SearchThread& thread, int alpha, int beta, SearchEntry* ss)
 
     int tt_score;
     bool tt_hit = false;
-    Entry* entry;
+    Slot entry;
     int16_t tt_static_eval;
     uint8_t entry_depth;
     NodeType entry_type;
@@ -50,7 +60,7 @@ int quiesce(SearchThread& thread, int alpha, int beta, SearchEntry* ss)
     const bool is_pv = beta - alpha > 1;
 
     std::tie(entry, entry_depth, entry_type, tt_move, tt_static_eval, tt_score) = TT::probe(
-        position.state->key, tt_hit, ss->plies);
+        position.state->key, tt_hit, ss->plies, thread.tt_stats);
 
     int raw_static_eval;
     Move best_move = null_move;
@@ -82,7 +92,7 @@ int quiesce(SearchThread& thread, int alpha, int beta, SearchEntry* ss)
             }
             else
             {
-                raw_static_eval = eval(position, thread.accumulator_stack);
+                raw_static_eval = cached_eval(thread);
             }
             stand_pat = thread.history.corrections.correct(raw_static_eval, position);
 
@@ -96,7 +106,7 @@ int quiesce(SearchThread& thread, int alpha, int beta, SearchEntry* ss)
         }
         else
         {
-            raw_static_eval = eval(position, accumulator_stack);
+            raw_static_eval = cached_eval(thread);
             stand_pat = thread.history.corrections.correct(raw_static_eval, position);
         }
 
@@ -110,7 +120,7 @@ int quiesce(SearchThread& thread, int alpha, int beta, SearchEntry* ss)
     Move picked_move;
     State st;
     auto type = NodeType::upper_bound;
-    std::forward_list<CaptureEntry> capture_searched;
+    SearchedList<CaptureEntry, 256> capture_searched;
     int move_searched = 0;
 
     while ((picked_move = move_picker.next_move().first))
@@ -127,8 +137,9 @@ int quiesce(SearchThread& thread, int alpha, int beta, SearchEntry* ss)
         uint8_t moving_piece = position.piece_on[picked_move.from()];
         ss->piece_to = (moving_piece << 6) + picked_move.to();
 
-        position.make_move(picked_move, st);
-        thread.accumulator_stack.push(position, picked_move);
+        TT::prefetch(position.key_after(picked_move));
+        position.make_move(picked_move, st, &thread.accumulator_stack.next());
+        thread.accumulator_stack.push(position);
 
         const int score = -quiesce(thread, -beta, -alpha, ss + 1);
 
@@ -166,7 +177,7 @@ int quiesce(SearchThread& thread, int alpha, int beta, SearchEntry* ss)
         if (uint8_t captured = position.piece_on[picked_move.to()];
             captured != nil || picked_move.flag() == MoveFlag::ep_capture)
         {
-            capture_searched.emplace_front(moving_piece, captured, picked_move);
+            capture_searched.push({moving_piece, captured, picked_move});
         }
     }
 
@@ -175,16 +186,17 @@ int quiesce(SearchThread& thread, int alpha, int beta, SearchEntry* ss)
         return -mate_value + ss->plies;
     }
 
-    TT::write(entry, position.state->key, best_move, 0, ss->plies, raw_static_eval, best_score, type, is_pv);
+    TT::write(entry, position.state->key, best_move, 0, ss->plies, raw_static_eval, best_score, type, is_pv,
+              thread.tt_stats);
 
     return best_score;
 }
 
 template <const bool root_node, const bool is_pv>
-int search(SearchThread& thread, int alpha, int beta, int depth, std::list<Move>& pv, const bool cut_node,
-           SearchEntry* ss)
+int search(SearchThread& thread, int alpha, int beta, int depth, const bool cut_node, SearchEntry* ss)
 {
-    ++thread.node_searched;
+    thread.count_node();
+    thread.pv_table[ss->plies].clear();
     if (Timer::is_search_cancelled) return alpha;
 
     if (ss->plies > thread.seldepth)
@@ -199,7 +211,7 @@ int search(SearchThread& thread, int alpha, int beta, int depth, std::list<Move>
 
     if (ss->plies > MAX_PLY)
     {
-        return not_in_check ? eval(position, accumulator_stack) : 0;
+        return not_in_check ? cached_eval(thread) : 0;
     }
 
     if constexpr (!root_node)
@@ -229,17 +241,18 @@ int search(SearchThread& thread, int alpha, int beta, int depth, std::list<Move>
     Move depth_best_move = null_move;
     Move tt_move = null_move;
     int tt_depth;
-    Entry* entry;
+    Slot entry;
     NodeType entry_type;
     ss->double_extensions = (ss - 1)->double_extensions;
-    uint64_t tt_key = position.state->key ^ static_cast<uint64_t>(ss->excluded.move) << 16;
+    uint64_t tt_key = position.state->key ^ ss->excluded.move;
 
     int raw_static_eval;
     bool improving = false;
 
     int16_t tt_static_eval;
 
-    std::tie(entry, tt_depth, entry_type, tt_move, tt_static_eval, tt_score) = TT::probe(tt_key, tt_hit, ss->plies);
+    std::tie(entry, tt_depth, entry_type, tt_move, tt_static_eval, tt_score) = TT::probe(
+        tt_key, tt_hit, ss->plies, thread.tt_stats);
 
     if (tt_hit)
     {
@@ -251,7 +264,6 @@ int search(SearchThread& thread, int alpha, int beta, int depth, std::list<Move>
             {
                 if (tt_score >= beta && tt_move)
                 {
-                    position.fill_info();
                     if (position.is_pseudo_legal(tt_move) && position.is_quiet(tt_move) && position.is_legal(tt_move))
                     {
                         thread.history.update_quiet_histories(position, depth, tt_move, ss, {});
@@ -278,7 +290,7 @@ int search(SearchThread& thread, int alpha, int beta, int depth, std::list<Move>
             }
             else
             {
-                raw_static_eval = eval(position, accumulator_stack);
+                raw_static_eval = cached_eval(thread);
             }
 
             ss->static_eval = thread.history.corrections.correct(raw_static_eval, position);
@@ -289,7 +301,7 @@ int search(SearchThread& thread, int alpha, int beta, int depth, std::list<Move>
         }
         else
         {
-            raw_static_eval = eval(position, accumulator_stack);
+            raw_static_eval = cached_eval(thread);
             ss->static_eval = thread.history.corrections.correct(raw_static_eval, position);
         }
 
@@ -335,12 +347,10 @@ int search(SearchThread& thread, int alpha, int beta, int depth, std::list<Move>
                 const int r = std::min((ss->static_eval - beta) / null_search_div(), 2) + depth *
                     null_search_depth_scale() / 1024 + 3 + improving;
                 State st;
-                std::list<Move> local_pv;
                 ss->piece_to = UINT16_MAX;
 
                 position.make_null_move(st);
-                const int null_score = -search<false, false>(thread, -beta, -beta + 1, depth - r, local_pv, !cut_node,
-                                                             ss + 1);
+                const int null_score = -search<false, false>(thread, -beta, -beta + 1, depth - r, !cut_node, ss + 1);
                 position.unmake_null_move();
 
                 if (Timer::is_search_cancelled) return alpha;
@@ -354,7 +364,7 @@ int search(SearchThread& thread, int alpha, int beta, int depth, std::list<Move>
                     thread.nmp_min_ply = ss->plies + 3 * (depth - r) / 4;
 
                     const auto verification_score = search<false, false>(
-                        thread, beta - 1, beta, depth - r, local_pv, !cut_node, ss + 1);
+                        thread, beta - 1, beta, depth - r, !cut_node, ss + 1);
 
                     thread.nmp_min_ply = 0;
 
@@ -384,16 +394,15 @@ int search(SearchThread& thread, int alpha, int beta, int depth, std::list<Move>
 
                 State st;
 
-                position.make_move(picked_move, st);
-                accumulator_stack.push(position, picked_move);
+                TT::prefetch(position.key_after(picked_move));
+                position.make_move(picked_move, st, &accumulator_stack.next());
+                accumulator_stack.push(position);
 
                 int prob_score = -quiesce(thread, -prob_beta, -prob_beta + 1, ss + 1);
 
                 if (prob_score >= prob_beta)
                 {
-                    std::list<Move> temp;
-                    prob_score = -search<false, false>(thread, -prob_beta, -prob_beta + 1, prob_depth - 1, temp,
-                                                       !cut_node,
+                    prob_score = -search<false, false>(thread, -prob_beta, -prob_beta + 1, prob_depth - 1, !cut_node,
                                                        ss + 1);
                 }
 
@@ -403,15 +412,15 @@ int search(SearchThread& thread, int alpha, int beta, int depth, std::list<Move>
                 if (prob_score >= prob_beta)
                 {
                     TT::write(entry, tt_key, picked_move, prob_depth, ss->plies, raw_static_eval, prob_score,
-                              NodeType::lower_bound, is_pv);
+                              NodeType::lower_bound, is_pv, thread.tt_stats);
                     return prob_score;
                 }
             }
         }
     }
 
-    std::forward_list<Move> quiets_searched;
-    std::forward_list<CaptureEntry> capture_searched;
+    SearchedList<Move, 256> quiets_searched;
+    SearchedList<CaptureEntry, 256> capture_searched;
 
     int move_searched = 0;
     int best_score = negative_infinity;
@@ -466,13 +475,12 @@ int search(SearchThread& thread, int alpha, int beta, int depth, std::list<Move>
             {
                 const auto singular_beta = std::max(tt_score - singular_margin() * depth / 1024, -mate_in_max_ply);
                 const auto singular_depth = (depth - 1) / 2;
-                std::list<Move> tmp_pv;
 
                 ss->excluded = tt_move;
                 const auto singular_score = search<false, false>(thread, singular_beta - 1, singular_beta,
-                                                                 singular_depth, tmp_pv,
-                                                                 cut_node, ss);
+                                                                 singular_depth, cut_node, ss);
                 ss->excluded = null_move;
+                thread.pv_table[ss->plies].clear();
 
                 if (singular_score < singular_beta)
                 {
@@ -505,15 +513,15 @@ int search(SearchThread& thread, int alpha, int beta, int depth, std::list<Move>
             }
         }
 
-        std::list<Move> local_pv;
         int score;
         State st;
 
         uint8_t moving_piece = position.piece_on[picked_move.from()];
         ss->piece_to = (moving_piece << 6) + picked_move.to();
 
-        position.make_move(picked_move, st);
-        accumulator_stack.push(position, picked_move);
+        TT::prefetch(position.key_after(picked_move));
+        position.make_move(picked_move, st, &accumulator_stack.next());
+        accumulator_stack.push(position);
 
         const auto new_depth = depth + extension;
 
@@ -536,21 +544,21 @@ int search(SearchThread& thread, int alpha, int beta, int depth, std::list<Move>
 
             reduction = std::clamp(reduction / 1024, 1, new_depth - 1);
 
-            score = -search<false, false>(thread, -alpha - 1, -alpha, new_depth - reduction, local_pv, true, ss + 1);
+            score = -search<false, false>(thread, -alpha - 1, -alpha, new_depth - reduction, true, ss + 1);
 
             if (score > alpha && reduction > 1)
             {
-                score = -search<false, false>(thread, -alpha - 1, -alpha, new_depth - 1, local_pv, !cut_node, ss + 1);
+                score = -search<false, false>(thread, -alpha - 1, -alpha, new_depth - 1, !cut_node, ss + 1);
             }
         }
         else if (!is_pv || move_searched)
         {
-            score = -search<false, false>(thread, -alpha - 1, -alpha, new_depth - 1, local_pv, !cut_node, ss + 1);
+            score = -search<false, false>(thread, -alpha - 1, -alpha, new_depth - 1, !cut_node, ss + 1);
         }
 
         if (is_pv && (!move_searched || score > alpha))
         {
-            score = -search<false, true>(thread, -beta, -alpha, new_depth - 1, local_pv, false, ss + 1);
+            score = -search<false, true>(thread, -beta, -alpha, new_depth - 1, false, ss + 1);
         }
 
         accumulator_stack.pop();
@@ -564,9 +572,8 @@ int search(SearchThread& thread, int alpha, int beta, int depth, std::list<Move>
             depth_best_move = picked_move;
             if (score > alpha)
             {
-                pv.clear();
-                pv.push_back(picked_move);
-                pv.splice(pv.end(), local_pv);
+                thread.pv_table[ss->plies].update(picked_move, thread.pv_table[ss->plies + 1]);
+                if constexpr (root_node) thread.principal_variation = thread.pv_table[0];
 
                 if (score >= beta)
                 {
@@ -595,14 +602,14 @@ int search(SearchThread& thread, int alpha, int beta, int depth, std::list<Move>
 
         if (position.is_quiet(picked_move))
         {
-            quiets_searched.push_front(picked_move);
+            quiets_searched.push(picked_move);
         }
         else
         {
             if (uint8_t captured = position.piece_on[picked_move.to()];
                 captured != nil || picked_move.flag() == MoveFlag::ep_capture)
             {
-                capture_searched.emplace_front(moving_piece, captured, picked_move);
+                capture_searched.push({moving_piece, captured, picked_move});
             }
         }
     }
@@ -617,7 +624,8 @@ int search(SearchThread& thread, int alpha, int beta, int depth, std::list<Move>
         return -mate_value + ss->plies;
     }
 
-    TT::write(entry, tt_key, depth_best_move, depth, ss->plies, raw_static_eval, best_score, type, is_pv);
+    TT::write(entry, tt_key, depth_best_move, depth, ss->plies, raw_static_eval, best_score, type, is_pv,
+              thread.tt_stats);
 
     if (!ss->excluded)
     {
@@ -652,7 +660,7 @@ void print_info(const SearchThread& thread)
     std::print("nodes {} nps {} hashfull {} time {} pv ",
                node_searched,
                static_cast<uint64_t>(static_cast<double>(node_searched) / elapsed * 1000000),
-               TT::full(),
+               ThreadPool::hashfull(),
                elapsed / 1000);
 
     for (auto x : thread.principal_variation)
@@ -694,8 +702,8 @@ void thread_search(const int thread_idx, const int search_depth)
         while (true)
         {
             const int new_depth = std::max(thread.root_depth - fail_high_reductions, 1);
-            thread.score = search<true, true>(thread, alpha, beta, new_depth, principal_variation, false,
-                                              &thread.search_stack[4]);
+            thread.score = search<true, true>(thread, alpha, beta, new_depth, false, &thread.search_stack[4]);
+            thread.publish_nodes();
 
             if (Timer::is_search_cancelled) break;
 
@@ -741,6 +749,8 @@ void thread_search(const int thread_idx, const int search_depth)
         }
         else if (thread.root_depth == search_depth) --thread.root_depth;
     }
+
+    thread.publish_nodes();
 }
 
 SearchThread& thread_vote()
@@ -1,4 +1,5 @@
 #include <numeric>
+#include <print>
 
 #include "thread.hpp"
 #include "transposition.hpp"
@@ -20,16 +21,18 @@ SearchThread::SearchThread()
 void SearchThread::new_game()
 {
     history.clear();
+    eval_cache.clear();
     clear_tt();
 }
 
-void SearchThread::clear_tt() const
+void SearchThread::clear_tt()
 {
     const auto length = TT::table_size / Options::threads;
     const auto start = length * id;
     const auto clear_len = id == Options::threads - 1 ? TT::table_size - start : length;
 
     TT::clear(&TT::table[start], clear_len);
+    tt_stats.clear();
 }
 
 void ThreadPool::resize()
@@ -108,6 +111,10 @@ void ThreadPool::worker_loop(const int thread_idx, uint32_t current_generation)
         {
             thread.new_game();
         }
+        else if (task == WorkerTask::ClearTT)
+        {
+            thread.clear_tt();
+        }
 
         {
             std::unique_lock tmp_lock(mtx);
@@ -141,8 +148,10 @@ void ThreadPool::setup()
 
 void ThreadPool::prepare()
 {
+    TT::keep_loaded_generation = false;
     for (auto& thread : threads)
     {
+        thread.nodes = 0;
         thread.node_searched = 0;
         thread.seldepth = 0;
         thread.principal_variation.clear();
@@ -159,6 +168,77 @@ uint64_t ThreadPool::node_searched()
     });
 }
 
+uint16_t ThreadPool::hashfull()
+{
+    uint64_t fresh_entries = 0;
+    for (const auto& thread : threads)
+    {
+        if (thread.tt_stats.generation.load(std::memory_order_relaxed) == TT::current_generation)
+        {
+            fresh_entries += thread.tt_stats.fresh_entries.load(std::memory_order_relaxed);
+        }
+    }
+    return TT::hashfull(fresh_entries);
+}
+
+std::pair<uint64_t, uint64_t> ThreadPool::eval_cache_stats()
+{
+    std::pair<uint64_t, uint64_t> stats{};
+    for (const auto& thread : threads)
+    {
+        stats.first += thread.eval_cache.probes;
+        stats.second += thread.eval_cache.hits;
+    }
+    return stats;
+}
+
+void ThreadPool::clear_tt_stats()
+{
+    for (auto& thread : threads) thread.tt_stats.clear();
+}
+
+void ThreadPool::print_tt_stats()
+{
+    TTStats total{};
+    for (const auto& thread : threads)
+    {
+        const auto& stats = thread.tt_stats;
+        total.probes += stats.probes;
+        total.hits += stats.hits;
+        total.collisions += stats.collisions;
+        total.writes += stats.writes;
+        total.overwrites += stats.overwrites;
+        for (int i = 0; i < TTStats::depth_bins; i++) total.depth_histogram[i] += stats.depth_histogram[i];
+    }
+
+    const auto rate = [](const uint64_t count, const uint64_t base)
+    {
+        return base ? static_cast<double>(count) * 100.0 / static_cast<double>(base) : 0.0;
+    };
+
+    std::println("info string TT probes {} hits {:.1f}% collisions {:.1f}% writes {} overwrites {:.1f}%",
+                 total.probes, rate(total.hits, total.probes), rate(total.collisions, total.probes),
+                 total.writes, rate(total.overwrites, total.writes));
+
+    static constexpr std::string_view depth_labels[TTStats::depth_bins] = {
+        "0", "1", "2-3", "4-7", "8-15", "16-31", "32-63", "64+"
+    };
+    std::print("info string TT write depths");
+    for (int i = 0; i < TTStats::depth_bins; i++)
+    {
+        std::print(" {}:{:.1f}%", depth_labels[i], rate(total.depth_histogram[i], total.writes));
+    }
+    std::println();
+
+    const auto [eval_probes, eval_hits] = eval_cache_stats();
+    std::println("info string Eval cache probes {} hits {:.1f}%", eval_probes, rate(eval_hits, eval_probes));
+
+    const auto occupancy = TT::occupancy();
+    std::println("info string TT sampled occupancy {} permille, by age 0:{} 1:{} 2:{} 3+:{} empty:{}",
+                 1000 - occupancy[4], occupancy[0], occupancy[1], occupancy[2], occupancy[3], occupancy[4]);
+    std::fflush(stdout);
+}
+
 void ThreadPool::shutdown()
 {
     if (!os_threads.empty())
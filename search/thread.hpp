@@ -3,11 +3,14 @@
 #include <vector>
 #include <condition_variable>
 #include <thread>
-#include <list>
+#include <array>
+#include <algorithm>
 #include <deque>
 
 #include "history.hpp"
+#include "transposition.hpp"
 #include "../eval/accumulators.hpp"
+#include "../eval/eval_cache.hpp"
 #include "../position/position.hpp"
 
 struct SearchEntry;
@@ -15,16 +18,45 @@ struct SearchEntry;
 template <bool silent>
 void thread_search(int thread_idx, int search_depth);
 
-enum class WorkerTask { None, Search, Refresh, NewGame };
+enum class WorkerTask { None, Search, Refresh, NewGame, ClearTT };
+
+struct PVLine
+{
+    std::array<Move, MAX_PLY + 2> moves;
+    int length{0};
+
+    void clear()
+    {
+        length = 0;
+    }
+
+    void update(const Move move, const PVLine& child)
+    {
+        moves[0] = move;
+        std::copy_n(child.moves.begin(), child.length, moves.begin() + 1);
+        length = child.length + 1;
+    }
+
+    [[nodiscard]] bool empty() const { return length == 0; }
+    [[nodiscard]] int size() const { return length; }
+    [[nodiscard]] Move front() const { return moves[0]; }
+    [[nodiscard]] auto begin() const { return moves.begin(); }
+    [[nodiscard]] auto end() const { return moves.begin() + length; }
+};
 
 struct SearchThread
 {
     AccumulatorStack accumulator_stack;
     std::vector<SearchEntry> search_stack{140};
     History history{};
+    TTStats tt_stats{};
+    EvalCache eval_cache{};
     Position position;
     State root_state{};
-    std::list<Move> principal_variation{};
+    // triangular table: row n holds the best line found from ply n of the current search
+    std::array<PVLine, MAX_PLY + 2> pv_table{};
+    PVLine principal_variation{};
+    uint64_t nodes{0};
     std::atomic<uint64_t> node_searched{0};
     int score{negative_infinity};
     int nmp_min_ply{0};
@@ -33,10 +65,22 @@ struct SearchThread
     int root_depth{};
     int id{};
 
+    static constexpr uint64_t node_publish_interval = 1024;
+
+    void count_node()
+    {
+        if (++nodes % node_publish_interval == 0) publish_nodes();
+    }
+
+    void publish_nodes()
+    {
+        node_searched.store(nodes, std::memory_order_relaxed);
+    }
+
     void search_stack_init();
     SearchThread();
     void new_game();
-    void clear_tt() const;
+    void clear_tt();
 };
 
 struct ThreadPool
@@ -65,5 +109,9 @@ struct ThreadPool
     static void setup();
     static void prepare();
     static uint64_t node_searched();
+    static uint16_t hashfull();
+    static std::pair<uint64_t, uint64_t> eval_cache_stats();
+    static void clear_tt_stats();
+    static void print_tt_stats();
     static void shutdown();
 };
\ No newline at end of file
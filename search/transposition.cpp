@@ -1,33 +1,164 @@
 #include <print>
 #include <utility>
 #include <cstring>
+#include <string_view>
+#include <charconv>
+#include <bit>
+#include <atomic>
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#include <filesystem>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 #include "transposition.hpp"
 #include "../options.hpp"
 
+uint16_t fold(const uint64_t data)
+{
+    return static_cast<uint16_t>(data ^ data >> 16 ^ data >> 32 ^ data >> 48);
+}
+
+std::pair<uint16_t, Entry> Bucket::load(const int index)
+{
+    const uint64_t packed = std::atomic_ref(data[index]).load(std::memory_order_relaxed);
+    const uint16_t key = std::atomic_ref(keys[index]).load(std::memory_order_relaxed) ^ fold(packed);
+    return {key, std::bit_cast<Entry>(packed)};
+}
+
+void Bucket::store(const int index, const uint16_t key, const Entry entry)
+{
+    const auto packed = std::bit_cast<uint64_t>(entry);
+    std::atomic_ref(data[index]).store(packed, std::memory_order_relaxed);
+    std::atomic_ref(keys[index]).store(static_cast<uint16_t>(key ^ fold(packed)), std::memory_order_relaxed);
+}
+
+struct HashFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t bucket_size;
+    uint64_t table_size;
+    uint8_t generation;
+    uint8_t padding[39];
+};
+
+static_assert(sizeof(HashFileHeader) == sizeof(Bucket));
+
+static constexpr char hash_file_magic[8] = {'C', 'A', 'T', 'A', '-', 'T', 'T', '\0'};
+static constexpr uint32_t hash_file_version = 1;
+
+void TTStats::record_fresh()
+{
+    if (generation.load(std::memory_order_relaxed) != TT::current_generation)
+    {
+        generation.store(TT::current_generation, std::memory_order_relaxed);
+        fresh_entries.store(0, std::memory_order_relaxed);
+    }
+    fresh_entries.store(fresh_entries.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void TTStats::clear()
+{
+    probes = 0;
+    hits = 0;
+    collisions = 0;
+    writes = 0;
+    overwrites = 0;
+    depth_histogram.fill(0);
+    fresh_entries.store(0, std::memory_order_relaxed);
+    generation.store(TT::current_generation, std::memory_order_relaxed);
+}
+
 namespace TT
 {
-    void clear(Entry* start, const size_t length)
+    static void* mapping = nullptr;
+    static size_t allocated_size = 0;
+    static size_t allocated_buckets = 0;
+
+    void clear(Bucket* start, const size_t length)
     {
-        std::memset(start, 0, length * sizeof(Entry));
+        std::memset(start, 0, length * sizeof(Bucket));
+    }
+
+#ifdef __linux__
+    static constexpr size_t huge_page_size = 2ull << 20;
+    static constexpr int mpol_interleave = 3;
+
+    Bucket* map_table(const size_t bytes)
+    {
+        void* memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory != MAP_FAILED)
+        {
+            page_mode = PageMode::huge;
+            return static_cast<Bucket*>(memory);
+        }
+
+        memory = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) return nullptr;
+
+        page_mode = madvise(memory, bytes, MADV_HUGEPAGE) == 0 ? PageMode::transparent : PageMode::normal;
+        return static_cast<Bucket*>(memory);
     }
 
+    int interleave(Bucket* memory, const size_t bytes)
+    {
+        uint64_t node_mask = 0;
+        std::error_code error;
+
+        for (const auto& node : std::filesystem::directory_iterator("/sys/devices/system/node", error))
+        {
+            const auto name = node.path().filename().string();
+            if (!name.starts_with("node")) continue;
+
+            int id = -1;
+            std::from_chars(name.data() + 4, name.data() + name.size(), id);
+            if (id >= 0 && id < 64) node_mask |= 1ull << id;
+        }
+
+        if (std::popcount(node_mask) < 2) return 1;
+
+        if (syscall(SYS_mbind, memory, bytes, mpol_interleave, &node_mask, sizeof(node_mask) * 8 + 1, 0) != 0)
+            return 1;
+
+        return std::popcount(node_mask);
+    }
+#endif
+
     void free_tt()
     {
+        if (table == nullptr) return;
 #ifdef _WIN32
         _aligned_free(table);
+#elifdef __linux__
+        munmap(mapping, allocated_size);
 #else
         std::free(table);
 #endif
+        table = nullptr;
     }
 
-    void alloc()
+    bool alloc()
     {
-        Entry* new_table;
+        Bucket* new_table;
+        size_t bytes = table_size * sizeof(Bucket);
+        bool zeroed = false;
 #ifdef _WIN32
-        new_table = static_cast<Entry*>(_aligned_malloc(table_size * sizeof(Entry), sizeof(Entry)));
+        new_table = static_cast<Bucket*>(_aligned_malloc(bytes, sizeof(Bucket)));
+#elifdef __linux__
+        bytes = (bytes + huge_page_size - 1) / huge_page_size * huge_page_size;
+        new_table = map_table(bytes);
+        zeroed = true;
 #else
-        new_table = static_cast<Entry*>(std::aligned_alloc(sizeof(Entry), table_size * sizeof(Entry)));
+        new_table = static_cast<Bucket*>(std::aligned_alloc(sizeof(Bucket), bytes));
 #endif
         if (!new_table)
         {
@@ -36,26 +167,162 @@ namespace TT
             if (table == nullptr) {
                 std::exit(1);
             }
-            return;
+            table_size = allocated_buckets;
+            return false;
         }
         free_tt();
         table = new_table;
-        clear(table, table_size);
+        mapping = new_table;
+        allocated_size = bytes;
+        allocated_buckets = table_size;
+        loaded_fresh_entries = 0;
+        keep_loaded_generation = false;
+#ifdef __linux__
+        numa_nodes = interleave(table, bytes);
+#endif
+
+        report_allocation();
+        return !zeroed;
+    }
+
+    void report_allocation()
+    {
+        static constexpr std::string_view mode_names[] = {
+            "regular pages", "transparent huge pages", "explicit huge pages", "a copy-on-write file mapping"
+        };
+
+        std::print("info string Hash {} MB using {}", table_size * sizeof(Bucket) >> 20,
+                   mode_names[std::to_underlying(page_mode)]);
+        if (numa_nodes > 1) std::print(", interleaved across {} NUMA nodes", numa_nodes);
+        std::println();
+        std::fflush(stdout);
+    }
+
+    bool save(const std::string& path)
+    {
+        const std::string temp_path = path + ".tmp";
+        std::FILE* file = std::fopen(temp_path.c_str(), "wb");
+        if (!file) return false;
+
+        HashFileHeader header{};
+        std::memcpy(header.magic, hash_file_magic, sizeof(header.magic));
+        header.version = hash_file_version;
+        header.bucket_size = sizeof(Bucket);
+        header.table_size = table_size;
+        header.generation = current_generation;
+
+        const bool written = std::fwrite(&header, sizeof(header), 1, file) == 1
+            && std::fwrite(table, sizeof(Bucket), table_size, file) == table_size;
+
+        if (std::fclose(file) != 0 || !written)
+        {
+            std::remove(temp_path.c_str());
+            return false;
+        }
+
+        return std::rename(temp_path.c_str(), path.c_str()) == 0;
+    }
+
+    bool valid_header(const HashFileHeader& header, const uint64_t file_size)
+    {
+        return std::memcmp(header.magic, hash_file_magic, sizeof(header.magic)) == 0
+            && header.version == hash_file_version
+            && header.bucket_size == sizeof(Bucket)
+            && header.table_size > 0
+            && file_size == sizeof(HashFileHeader) + header.table_size * sizeof(Bucket);
     }
 
-    void resize(const uint32_t new_size_in_mb)
+    bool load(const std::string& path)
+    {
+#ifdef __linux__
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat file_stat{};
+        if (fstat(fd, &file_stat) != 0 || static_cast<uint64_t>(file_stat.st_size) < sizeof(HashFileHeader))
+        {
+            close(fd);
+            return false;
+        }
+
+        const auto file_size = static_cast<size_t>(file_stat.st_size);
+        void* memory = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (memory == MAP_FAILED) return false;
+
+        const auto& header = *static_cast<const HashFileHeader*>(memory);
+        if (!valid_header(header, file_size))
+        {
+            munmap(memory, file_size);
+            return false;
+        }
+
+        madvise(memory, file_size, MADV_WILLNEED);
+
+        free_tt();
+        mapping = memory;
+        allocated_size = file_size;
+        table = reinterpret_cast<Bucket*>(static_cast<char*>(memory) + sizeof(HashFileHeader));
+        table_size = header.table_size;
+        allocated_buckets = table_size;
+        current_generation = header.generation;
+        page_mode = PageMode::file;
+        numa_nodes = 1;
+        report_allocation();
+#else
+        std::error_code error;
+        const uint64_t file_size = std::filesystem::file_size(path, error);
+        if (error) return false;
+
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file) return false;
+
+        HashFileHeader header{};
+        if (std::fread(&header, sizeof(header), 1, file) != 1 || !valid_header(header, file_size))
+        {
+            std::fclose(file);
+            return false;
+        }
+
+        // off Linux the table is never pre-zeroed, so alloc only reports false when it failed and kept the old table
+        table_size = header.table_size;
+        if (!alloc())
+        {
+            std::fclose(file);
+            return false;
+        }
+
+        const bool read = std::fread(table, sizeof(Bucket), table_size, file) == table_size;
+        std::fclose(file);
+        if (!read)
+        {
+            clear(table, table_size);
+            return false;
+        }
+        current_generation = header.generation;
+#endif
+        loaded_fresh_entries = static_cast<uint64_t>(occupancy()[0]) * table_size * Bucket::size / 1000;
+        keep_loaded_generation = true;
+        Options::hash = table_size * sizeof(Bucket) >> 20;
+        return true;
+    }
+
+    bool resize(const uint32_t new_size_in_mb)
     {
         if (new_size_in_mb != Options::hash)
         {
             Options::hash = new_size_in_mb;
-            table_size = (static_cast<uint64_t>(new_size_in_mb) << 20) / sizeof(Entry);
-            alloc();
+            table_size = (static_cast<uint64_t>(new_size_in_mb) << 20) / sizeof(Bucket);
+            return alloc();
         }
+        return false;
     }
 
     void advance()
     {
+        if (keep_loaded_generation) return;
         current_generation += 8;
+        loaded_fresh_entries = 0;
     }
 
     uint64_t index_of(const uint64_t& key)
@@ -63,26 +330,85 @@ namespace TT
         return static_cast<uint64_t>((static_cast<__uint128_t>(key) * static_cast<__uint128_t>(table_size)) >> 64);
     }
 
-    __attribute__((no_sanitize_thread))
-    std::tuple<Entry*, int, NodeType, Move, int, int> probe(const uint64_t key, bool& match, const uint8_t ply)
+    void prefetch(const uint64_t key)
+    {
+        __builtin_prefetch(&table[index_of(key)]);
+    }
+
+    uint16_t key_of(const uint64_t& key)
+    {
+        return static_cast<uint16_t>(key);
+    }
+
+    int relative_age(const Entry& entry)
+    {
+        return (263 + current_generation - entry.age_pv_type) & 0b11111000;
+    }
+
+    int replace_value(const Entry& entry)
     {
-        Entry* entry = &table[index_of(key)];
-        int score;
-        if (entry->key == key)
+        return entry.depth + entry.is_pv() * 2 - relative_age(entry);
+    }
+
+    std::tuple<Slot, int, NodeType, Move, int, int> probe(const uint64_t key, bool& match, const uint8_t ply,
+                                                          TTStats& stats)
+    {
+        auto& bucket = table[index_of(key)];
+        const uint16_t key16 = key_of(key);
+        ++stats.probes;
+
+        for (int i = 0; i < Bucket::size; i++)
         {
+            auto [stored_key, entry] = bucket.load(i);
+            if (stored_key != key16 || entry.is_empty()) continue;
+
             match = true;
-            score = static_cast<int>(entry->score);
+            ++stats.hits;
+            if ((entry.age_pv_type & 0b11111000) != current_generation)
+            {
+                entry.age_pv_type = current_generation | (entry.age_pv_type & 0b111);
+                bucket.store(i, key16, entry);
+                stats.record_fresh();
+            }
+
+            int score = static_cast<int>(entry.score);
             if (score < mated_in_max_ply)
                 score += ply;
             else if (score > mate_in_max_ply)
                 score -= ply;
+
+            return {{&bucket, i}, entry.depth, static_cast<NodeType>(entry.age_pv_type & 0b11), entry.best_move,
+                    entry.static_eval, score};
         }
-        return {entry, entry->depth, static_cast<NodeType>(entry->age_pv_type & 0b11), entry->best_move, entry->static_eval, score};
+
+        // an empty slot always wins, otherwise the entry with the lowest depth minus age is evicted
+        int replace = 0;
+        int lowest_value = INT32_MAX;
+        bool bucket_full = true;
+        for (int i = 0; i < Bucket::size; i++)
+        {
+            const auto entry = bucket.load(i).second;
+            if (entry.is_empty())
+            {
+                replace = i;
+                bucket_full = false;
+                break;
+            }
+
+            if (const int value = replace_value(entry); value < lowest_value)
+            {
+                replace = i;
+                lowest_value = value;
+            }
+        }
+
+        if (bucket_full) ++stats.collisions;
+
+        return {{&bucket, replace}, 0, NodeType::none, null_move, score_none, score_none};
     }
 
-    __attribute__((no_sanitize_thread))
-    void write(Entry* entry, const uint64_t key, const Move best_move, const int depth, const uint8_t ply,
-                      const int static_eval, int score, const NodeType type, const bool pv)
+    void write(const Slot slot, const uint64_t key, const Move best_move, const int depth, const uint8_t ply,
+               const int static_eval, int score, const NodeType type, const bool pv, TTStats& stats)
     {
         if (score < mated_in_max_ply)
         {
@@ -93,31 +419,69 @@ namespace TT
             score += ply;
         }
 
+        const uint16_t key16 = key_of(key);
+        auto& [bucket, index] = slot;
+        auto [stored_key, entry] = bucket->load(index);
+        const bool same_position = stored_key == key16;
+
         if (!(type == NodeType::exact
-            || (entry->age_pv_type & 0b11111000) != current_generation
-            || key != entry->key
-            || depth + 4 + entry->is_pv() * 2 >= entry->depth))
+            || (entry.age_pv_type & 0b11111000) != current_generation
+            || !same_position
+            || depth + 4 + entry.is_pv() * 2 >= entry.depth))
             return;
 
-        if (best_move || entry->key != key)
+        ++stats.writes;
+        ++stats.depth_histogram[std::min<int>(std::bit_width(static_cast<unsigned>(depth)), TTStats::depth_bins - 1)];
+
+        if (entry.is_empty() || (entry.age_pv_type & 0b11111000) != current_generation)
+        {
+            stats.record_fresh();
+        }
+        else if (!same_position)
+        {
+            ++stats.overwrites;
+        }
+
+        if (best_move || !same_position)
         {
-            entry->best_move = best_move;
+            entry.best_move = best_move;
         }
 
-        entry->key = key;
-        entry->depth = depth;
-        entry->score = static_cast<int16_t>(score);
-        entry->static_eval = static_cast<int16_t>(static_eval);
-        entry->age_pv_type = current_generation + std::to_underlying(type) + (pv << 2);
+        entry.depth = depth;
+        entry.score = static_cast<int16_t>(score);
+        entry.static_eval = static_cast<int16_t>(static_eval);
+        entry.age_pv_type = current_generation + std::to_underlying(type) + (pv << 2);
+
+        bucket->store(index, key16, entry);
     }
 
-    uint16_t full()
+    uint16_t hashfull(const uint64_t fresh_entries)
     {
-        uint16_t hash_full = 0;
-        for (int i = 0; i < 1000; i++)
+        return static_cast<uint16_t>(std::min<uint64_t>((fresh_entries + loaded_fresh_entries) * 1000 /
+                                                        (table_size * Bucket::size), 1000));
+    }
+
+    std::array<uint16_t, 5> occupancy()
+    {
+        std::array<int, 5> counts{};
+        const int sampled = static_cast<int>(std::min<uintptr_t>(table_size, 1000));
+
+        for (int i = 0; i < sampled; i++)
+        {
+            for (int j = 0; j < Bucket::size; j++)
+            {
+                if (const auto entry = table[i].load(j).second; entry.is_empty())
+                    counts[4]++;
+                else
+                    counts[std::min(relative_age(entry) / 8, 3)]++;
+            }
+        }
+
+        std::array<uint16_t, 5> per_mille{};
+        for (int i = 0; i < 5; i++)
         {
-            if ((table[i].age_pv_type & 0b11111000) == current_generation) hash_full++;
+            per_mille[i] = static_cast<uint16_t>(counts[i] * 1000 / (sampled * Bucket::size));
         }
-        return hash_full;
+        return per_mille;
     }
 }
@@ -2,6 +2,10 @@
 
 #include <cstdint>
 #include <tuple>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <string>
 
 #include "../position/move.hpp"
 
@@ -12,7 +16,6 @@ enum class NodeType: uint8_t
 
 struct Entry
 {
-    uint64_t key;
     int16_t score;
     int16_t static_eval;
     Move best_move;
@@ -23,24 +26,81 @@ struct Entry
     {
         return ((age_pv_type >> 2) & 1) != 0;
     }
+
+    [[nodiscard]] bool is_empty() const
+    {
+        return (age_pv_type & 0b11) == 0;
+    }
+};
+
+struct alignas(64) Bucket
+{
+    static constexpr int size = 6;
+
+    uint64_t data[size];
+    uint16_t keys[size];
+    uint8_t padding[4];
+
+    [[nodiscard]] std::pair<uint16_t, Entry> load(int index);
+    void store(int index, uint16_t key, Entry entry);
+};
+
+struct Slot
+{
+    Bucket* bucket;
+    int index;
+};
+
+struct TTStats
+{
+    static constexpr int depth_bins = 8;
+
+    uint64_t probes;
+    uint64_t hits;
+    uint64_t collisions;
+    uint64_t writes;
+    uint64_t overwrites;
+    std::array<uint64_t, depth_bins> depth_histogram;
+    std::atomic<uint64_t> fresh_entries;
+    std::atomic<uint8_t> generation;
+
+    void record_fresh();
+    void clear();
+};
+
+static_assert(sizeof(Entry) == sizeof(uint64_t));
+static_assert(sizeof(Bucket) == 64);
+
+enum class PageMode: uint8_t
+{
+    normal, transparent, huge, file
 };
 
 namespace TT
 {
-    inline uintptr_t table_size = (64ull << 20) / sizeof(Entry);
+    inline uintptr_t table_size = (64ull << 20) / sizeof(Bucket);
     inline uint8_t current_generation = 0;
-    inline Entry* table = nullptr;
+    inline Bucket* table = nullptr;
+    inline PageMode page_mode = PageMode::normal;
+    inline int numa_nodes = 1;
+    // current-generation entries already in a loaded hash file, which no thread's fresh counter has seen
+    inline uint64_t loaded_fresh_entries = 0;
+    // a loaded table keeps its generation through position commands until the next search starts
+    inline bool keep_loaded_generation = false;
 
-    void clear(Entry* start, size_t length);
+    void clear(Bucket* start, size_t length);
     void free_tt();
-    void alloc();
-    void resize(uint32_t new_size_in_mb);
+    [[nodiscard]] bool alloc();
+    void report_allocation();
+    bool save(const std::string& path);
+    bool load(const std::string& path);
+    [[nodiscard]] bool resize(uint32_t new_size_in_mb);
     void advance();
-    __attribute__((no_sanitize_thread))
-    std::tuple<Entry*, int, NodeType, Move, int, int> probe(uint64_t key, bool& match, uint8_t ply);
-    __attribute__((no_sanitize_thread))
-    void write(Entry* entry, uint64_t key, Move best_move, int depth, uint8_t ply,
-               int static_eval, int score, NodeType type, bool pv);
+    void prefetch(uint64_t key);
+    std::tuple<Slot, int, NodeType, Move, int, int> probe(uint64_t key, bool& match, uint8_t ply, TTStats& stats);
+    void write(Slot slot, uint64_t key, Move best_move, int depth, uint8_t ply,
+               int static_eval, int score, NodeType type, bool pv, TTStats& stats);
 
-    uint16_t full();
+    uint16_t hashfull(uint64_t fresh_entries);
+    std::array<uint16_t, 5> occupancy();
 }
@@ -1,12 +1,18 @@
+#include <cctype>
 #include <charconv>
+#include <chrono>
 #include <ranges>
 #include <iostream>
+#include <fstream>
+#include <vector>
 #include <algorithm>
 #include <print>
 
 #include "engine.hpp"
 #include "options.hpp"
 #include "position/bench.hpp"
+#include "position/fen.hpp"
+#include "position/position.hpp"
 #include "position/perft.hpp"
 #include "search/search.hpp"
 #include "search/thread.hpp"
@@ -17,6 +23,7 @@
 #include "uci.hpp"
 #include "search/transposition.hpp"
 #include "eval/nnue.hpp"
+#include "eval/simd/simd.hpp"
 
 namespace UCI
 {
@@ -43,14 +50,50 @@ namespace UCI
             std::from_chars(value.data(), value.data() + value.size(), new_size);
 
             if (new_size < 1 || new_size > 2048) return;
-            TT::resize(static_cast<uint32_t>(new_size));
+            resize_hash(static_cast<uint32_t>(new_size));
+        }
+        else if (name == "HashFile")
+        {
+            const auto value_pos = option.find(" value ");
+            const auto value = value_pos == std::string_view::npos ? "" : option.substr(value_pos + 7);
+            Options::hash_file = value == "<empty>" ? "" : std::string(value);
+        }
+        else if (name == "NetCacheDir")
+        {
+            const auto value_pos = option.find(" value ");
+            const auto value = value_pos == std::string_view::npos ? "" : option.substr(value_pos + 7);
+            Options::net_cache_dir = value == "<empty>" ? "" : std::string(value);
+
+            if (!Options::eval_file.empty() && !set_eval_file(Options::eval_file))
+            {
+                std::println("info string Cannot reload net from {}", Options::eval_file);
+                std::fflush(stdout);
+            }
+        }
+        else if (name == "EvalFile")
+        {
+            const auto value_pos = option.find(" value ");
+            const auto value = value_pos == std::string_view::npos ? "" : option.substr(value_pos + 7);
+            const std::string path = value == "<empty>" ? "" : std::string(value);
+
+            if (set_eval_file(path))
+            {
+                Options::eval_file = path;
+                std::println("info string Using {} net", path.empty() ? "embedded" : path);
+            }
+            else
+            {
+                std::println("info string Cannot load net from {}, keeping {}", path,
+                             Options::eval_file.empty() ? "embedded net" : Options::eval_file);
+            }
+            std::fflush(stdout);
         }
         else if (name == "Clear")
         {
             ++it;
             if (std::string_view{*it} == "Hash")
             {
-                TT::clear(TT::table, TT::table_size);
+                clear_hash();
             }
         }
         else if (name == "Threads")
@@ -132,6 +175,173 @@ namespace UCI
         run_bench(depth, tt_size);
     }
 
+    void eval_bench(std::string_view args)
+    {
+        auto tokens = args | std::views::split(' ');
+        auto it = tokens.begin();
+
+        if (it != tokens.end()) ++it;
+
+        uint64_t iterations = 1000000;
+        if (it != tokens.end())
+        {
+            std::from_chars((*it).begin(), (*it).end(), iterations);
+        }
+
+        auto& thread = ThreadPool::get(0);
+        bench_forward(thread.position, thread.accumulator_stack, iterations);
+        std::fflush(stdout);
+    }
+
+    void export_net(const std::string_view args)
+    {
+        auto tokens = args | std::views::split(' ');
+        auto it = tokens.begin();
+
+        if (it != tokens.end()) ++it;
+        if (it == tokens.end())
+        {
+            std::println("info string Usage: exportnet <path> [int16|int8]");
+            return;
+        }
+
+        const std::string path{(*it).begin(), (*it).end()};
+        ++it;
+
+        auto format = NetFormat::int16;
+        if (it != tokens.end() && std::string_view{*it} == "int8") format = NetFormat::int8;
+
+        if (export_network(path, format))
+        {
+            std::println("info string Net exported to {}", path);
+        }
+        else
+        {
+            std::println("info string Cannot export net to {}", path);
+        }
+        std::fflush(stdout);
+    }
+
+    void eval_batch(const std::string_view args)
+    {
+        auto tokens = args | std::views::split(' ');
+        auto it = tokens.begin();
+
+        if (it != tokens.end()) ++it;
+        if (it == tokens.end())
+        {
+            std::println("info string Usage: evalbatch <fen file> [output file]");
+            return;
+        }
+
+        const std::string input_path{(*it).begin(), (*it).end()};
+        ++it;
+
+        std::ifstream input(input_path);
+        if (!input)
+        {
+            std::println("info string Cannot open {}", input_path);
+            return;
+        }
+
+        std::FILE* output = stdout;
+        if (it != tokens.end())
+        {
+            const std::string output_path{(*it).begin(), (*it).end()};
+            output = std::fopen(output_path.c_str(), "w");
+            if (!output)
+            {
+                std::println("info string Cannot open {}", output_path);
+                return;
+            }
+        }
+
+        static constexpr size_t chunk_size = 4096;
+        std::vector<std::string> fens;
+        std::vector<Position> positions;
+        std::vector<int16_t> scores;
+        State st{};
+        uint64_t scored = 0;
+        uint64_t invalid = 0;
+
+        const auto start_time = std::chrono::steady_clock::now();
+
+        auto flush_chunk = [&]
+        {
+            scores.resize(positions.size());
+            ::eval_batch(positions, scores);
+            for (size_t i = 0; i < positions.size(); i++) std::println(output, "{} | {}", fens[i], scores[i]);
+            scored += positions.size();
+            fens.clear();
+            positions.clear();
+        };
+
+        std::string line;
+        while (std::getline(input, line))
+        {
+            // annotated data lines ("<fen> | <score> | <result>") are scored on the fen alone
+            std::string_view fen = line;
+            fen = fen.substr(0, fen.find('|'));
+            while (!fen.empty() && std::isspace(static_cast<unsigned char>(fen.back()))) fen.remove_suffix(1);
+            if (fen.empty()) continue;
+
+            Position pos{};
+            if (fen_parse(pos, st, fen) == -1)
+            {
+                invalid++;
+                continue;
+            }
+
+            fens.emplace_back(fen);
+            positions.push_back(pos);
+            if (positions.size() == chunk_size) flush_chunk();
+        }
+        if (!positions.empty()) flush_chunk();
+
+        const auto time_taken = std::max<int64_t>(1, std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start_time).count());
+
+        if (output != stdout) std::fclose(output);
+        std::println("info string Scored {} positions ({} invalid) in {} ms, {} positions/s", scored, invalid,
+                     time_taken / 1000, static_cast<uint64_t>(static_cast<double>(scored) / time_taken * 1000000.0));
+        std::fflush(stdout);
+    }
+
+    void save_hash()
+    {
+        if (Options::hash_file.empty())
+        {
+            std::println("info string No HashFile set");
+        }
+        else if (TT::save(Options::hash_file))
+        {
+            std::println("info string Hash saved to {}", Options::hash_file);
+        }
+        else
+        {
+            std::println("info string Cannot save hash to {}", Options::hash_file);
+        }
+        std::fflush(stdout);
+    }
+
+    void load_hash()
+    {
+        if (Options::hash_file.empty())
+        {
+            std::println("info string No HashFile set");
+        }
+        else if (TT::load(Options::hash_file))
+        {
+            ThreadPool::clear_tt_stats();
+            std::println("info string Hash loaded from {}", Options::hash_file);
+        }
+        else
+        {
+            std::println("info string Cannot load hash from {}", Options::hash_file);
+        }
+        std::fflush(stdout);
+    }
+
     void go(const std::string_view input)
     {
         auto tokens = input | std::views::split(' ');
@@ -292,6 +502,9 @@ namespace UCI
                     std::println("id author masceron\n");
                     std::println("option name Hash type spin default 64 min 1 max 2048");
                     std::println("option name Clear Hash type button");
+                    std::println("option name HashFile type string default <empty>");
+                    std::println("option name EvalFile type string default <empty>");
+                    std::println("option name NetCacheDir type string default <empty>");
                     std::println("option name Threads type spin default 1 min 1 max 1024");
                     std::println("option name ShowCurrMove type check default false");
                     std::println("option name Verbose type check default false");
@@ -299,6 +512,7 @@ namespace UCI
 #ifdef SPSA_TUNE
                     Tuning::print_options();
 #endif
+                    std::println("info string NNUE kernels: {}", NNUE::kernels.name);
                     std::println("uciok");
                     std::fflush(stdout);
                 }
@@ -321,6 +535,30 @@ namespace UCI
                 {
                     bench(input_view);
                 }
+                else if (command == "evalbench")
+                {
+                    eval_bench(input_view);
+                }
+                else if (command == "evalbatch")
+                {
+                    eval_batch(input_view);
+                }
+                else if (command == "exportnet")
+                {
+                    export_net(input_view);
+                }
+                else if (command == "savehash")
+                {
+                    save_hash();
+                }
+                else if (command == "loadhash")
+                {
+                    load_hash();
+                }
+                else if (command == "ttstats")
+                {
+                    ThreadPool::print_tt_stats();
+                }
 #ifdef SPSA_TUNE
                 else if (command == "spsa")
                 {
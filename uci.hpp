@@ -7,5 +7,6 @@ namespace UCI
     inline std::thread search_thread;
 
     void bench(std::string_view args);
+    void eval_batch(std::string_view args);
     void process();
 }